@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include "search.h"
+
+// === bench.h ===
+// Fixed benchmark: searches a built-in set of positions (openings,
+// middlegames, endgames and a few tactical shots) to a fixed depth, each with
+// a cleared hash table and history, and reports the total node count and
+// speed. With one thread the node count is deterministic: it is a signature
+// of the search's behaviour, so a change meant only to be faster must leave it
+// unchanged. With more threads the nodes vary from run to run and the
+// summed time to depth is the figure to compare across thread counts.
+// Run as "bench [depth] [threads] [hash]", from UCI or the command line.
+
+constexpr int DEFAULT_BENCH_DEPTH{ 10 };
+constexpr int DEFAULT_BENCH_THREADS{ 1 };
+constexpr int DEFAULT_BENCH_HASH_MB{ 16 };
+
+// Runs the bench on search's current threads and the global TT, writing one
+// line per position and a summary to out. Returns the total node count.
+uint64_t bench(Search& search, int depth, std::ostream& out);
@@ -30,34 +30,96 @@ enum Square : int {
   NO_SQ
 };
 
-// Indexed by square on the chessboard.
-extern std::array<Bitboard, NUM_SQUARES> knightAttacks;
-extern std::array<Bitboard, NUM_SQUARES> kingAttacks;
-// Pawn attacks depend on colour, so indexed by square then colour.
-extern std::array<std::array<Bitboard, NUM_SQUARES>, NUM_COLOURS> pawnAttacks;
+// === Compile-time table generation ===
+// All lookup tables are built by constexpr functions, so they live in
+// read-only data, need no start-up code and can be folded by the compiler.
+
+// --- Simple piece attacks ---
+constexpr Bitboard NOT_A_FILE{ 0xFEFEFEFEFEFEFEFEULL };
+constexpr Bitboard NOT_H_FILE{ 0x7F7F7F7F7F7F7F7FULL };
+constexpr Bitboard NOT_AB_FILE{ 0xFCFCFCFCFCFCFCFCULL };
+constexpr Bitboard NOT_GH_FILE{ 0x3F3F3F3F3F3F3F3FULL };
+
+constexpr std::array<Bitboard, NUM_SQUARES> makeKnightAttacks() {
+    std::array<Bitboard, NUM_SQUARES> table{};
+    for (int sq = 0; sq < NUM_SQUARES; sq++) {
+        Bitboard bb{ 1ULL << sq };
+        table[sq] = ((((bb << 16) << 1) & NOT_A_FILE) | (((bb << 16) >> 1) & NOT_H_FILE) |
+            (((bb >> 16) << 1) & NOT_A_FILE) | (((bb >> 16) >> 1) & NOT_H_FILE) |
+            (((bb << 8) << 2) & NOT_AB_FILE) | (((bb << 8) >> 2) & NOT_GH_FILE) |
+            (((bb >> 8) << 2) & NOT_AB_FILE) | (((bb >> 8) >> 2) & NOT_GH_FILE));
+    }
+    return table;
+}
+
+constexpr std::array<Bitboard, NUM_SQUARES> makeKingAttacks() {
+    std::array<Bitboard, NUM_SQUARES> table{};
+    for (int sq = 0; sq < NUM_SQUARES; sq++) {
+        Bitboard bb{ 1ULL << sq };
+        table[sq] = (((bb << 9) & NOT_A_FILE) | (bb << 8) | ((bb << 7) & NOT_H_FILE) | ((bb << 1) & NOT_A_FILE) |
+            ((bb >> 1) & NOT_H_FILE) | ((bb >> 7) & NOT_A_FILE) | (bb >> 8) | ((bb >> 9) & NOT_H_FILE));
+    }
+    return table;
+}
+
+constexpr std::array<std::array<Bitboard, NUM_SQUARES>, NUM_COLOURS> makePawnAttacks() {
+    // Will generate legal moves for illegal pawn positions too (1st/8th rank)
+    std::array<std::array<Bitboard, NUM_SQUARES>, NUM_COLOURS> table{};
+    for (int sq = 0; sq < NUM_SQUARES; sq++) {
+        Bitboard bb{ 1ULL << sq };
+        table[WHITE][sq] = ((bb << 9) & NOT_A_FILE) | ((bb << 7) & NOT_H_FILE);
+        table[BLACK][sq] = ((bb >> 7) & NOT_A_FILE) | ((bb >> 9) & NOT_H_FILE);
+    }
+    return table;
+}
+
+// --- Pawn structure masks ---
+constexpr Bitboard FILE_A{ 0x0101010101010101ULL };
+constexpr Bitboard RANK_1{ 0xFFULL };
+constexpr Bitboard RANK_8{ 0xFFULL << 56 };
+
+constexpr std::array<Bitboard, 8> makeAdjacentFiles() {
+    std::array<Bitboard, 8> table{};
+    for (int f = 0; f < 8; f++)
+        table[f] = (f > 0 ? FILE_A << (f - 1) : 0) | (f < 7 ? FILE_A << (f + 1) : 0);
+    return table;
+}
 
-// Indexed by square on the chessboard. Contains the Bitboard of the
-// corresponding (anti)diagonal passing through that square.
-extern std::array<Bitboard, 15> diagMasks;
-extern std::array<Bitboard, 15> antidiagMasks;
+constexpr std::array<std::array<Bitboard, NUM_SQUARES>, NUM_COLOURS> makeForwardFiles() {
+    // Squares in front of sq on its own file, as seen by each colour.
+    std::array<std::array<Bitboard, NUM_SQUARES>, NUM_COLOURS> table{};
+    for (int sq = 0; sq < NUM_SQUARES; sq++) {
+        for (int s = sq + 8; s < NUM_SQUARES; s += 8)
+            table[WHITE][sq] |= 1ULL << s;
+        for (int s = sq - 8; s >= 0; s -= 8)
+            table[BLACK][sq] |= 1ULL << s;
+    }
+    return table;
+}
+
+constexpr std::array<std::array<Bitboard, NUM_SQUARES>, NUM_COLOURS> makePassedPawnMasks() {
+    // A pawn is passed if no enemy pawn is on this mask: the squares in front
+    // of it on its own and the adjacent files.
+    std::array<std::array<Bitboard, NUM_SQUARES>, NUM_COLOURS> table{};
+    const auto forward{ makeForwardFiles() };
+    for (int co = 0; co < NUM_COLOURS; co++) {
+        for (int sq = 0; sq < NUM_SQUARES; sq++) {
+            table[co][sq] = forward[co][sq];
+            if (sq & 7)
+                table[co][sq] |= forward[co][sq - 1];
+            if ((sq & 7) != 7)
+                table[co][sq] |= forward[co][sq + 1];
+        }
+    }
+    return table;
+}
 
 // Indexed by square on the chessboard.
-extern std::array<Bitboard, NUM_SQUARES> knightAttacks;
-extern std::array<Bitboard, NUM_SQUARES> kingAttacks;
-// Pawn attacks depend on colour, so indexed by square then colour.
-extern std::array<std::array<Bitboard, NUM_SQUARES>, NUM_COLOURS> pawnAttacks;
-
-void initialiseFirstRankAttacks();
-void initialiseFirstFileAttacks();
-void initialiseAllDiagMasks();
-void initialiseKnightAttacks();
-void initialiseKingAttacks();
-void initialisePawnAttacks();
-void initializeLookupTables();
-
-Bitboard findDiagAttacks(int sq, const Bitboard& occupancy);
-Bitboard findAntidiagAttacks(int sq, const Bitboard& occupancy);
-Bitboard findRankAttacks(int sq, const Bitboard& occupancy);
-Bitboard findFileAttacks(int sq, const Bitboard& occupancy);
-int leastSignificantBit(uint64_t x);
-int mostSignificantBit(uint64_t x);
\ No newline at end of file
+inline constexpr std::array<Bitboard, NUM_SQUARES> knightAttacks{ makeKnightAttacks() };
+inline constexpr std::array<Bitboard, NUM_SQUARES> kingAttacks{ makeKingAttacks() };
+// Pawn attacks depend on colour, so indexed by colour then square.
+inline constexpr std::array<std::array<Bitboard, NUM_SQUARES>, NUM_COLOURS> pawnAttacks{ makePawnAttacks() };
+// Files next to each file, indexed by file.
+inline constexpr std::array<Bitboard, 8> adjacentFiles{ makeAdjacentFiles() };
+inline constexpr std::array<std::array<Bitboard, NUM_SQUARES>, NUM_COLOURS> forwardFiles{ makeForwardFiles() };
+inline constexpr std::array<std::array<Bitboard, NUM_SQUARES>, NUM_COLOURS> passedPawnMasks{ makePassedPawnMasks() };
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include "bitboard.h"
+
+// === bitops.h ===
+// Bit counting and scanning used by move generation and evaluation.
+// The implementation is chosen when the engine is built: compiler builtins on
+// GCC/Clang, intrinsics on MSVC, and a portable fallback otherwise. Building
+// for a CPU with POPCNT/BMI1 (e.g. -march=native or /arch:AVX2) turns these
+// into single POPCNT/TZCNT/LZCNT instructions.
+// PEXT is used when the build targets BMI2 or USE_PEXT is defined. Avoid
+// USE_PEXT on AMD CPUs before Zen 3, where PEXT is microcoded and slow.
+// MSVC never defines __BMI2__, but every x64 CPU with AVX2 also has BMI2.
+// The Release configurations of chess.vcxproj build with /arch:AVX2, so
+// they need a Haswell or later CPU; use a Debug build on older ones.
+#if (defined(__BMI2__) || (defined(_MSC_VER) && defined(_M_X64) && defined(__AVX2__))) \
+    && !defined(USE_PEXT)
+#define USE_PEXT
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#if defined(USE_PEXT)
+#include <immintrin.h>
+#endif
+
+// Number of set bits.
+inline int popCount(Bitboard bb) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(bb);
+#elif defined(_MSC_VER) && defined(_M_X64) && defined(__AVX__)
+    // __popcnt64 emits POPCNT unconditionally, so only use it when the
+    // target architecture guarantees the instruction.
+    return static_cast<int>(__popcnt64(bb));
+#else
+    bb -= (bb >> 1) & 0x5555555555555555ULL;
+    bb = ((bb >> 2) & 0x3333333333333333ULL) + (bb & 0x3333333333333333ULL);
+    bb = (((bb >> 4) + bb) & 0x0F0F0F0F0F0F0F0FULL) * 0x0101010101010101ULL;
+    return static_cast<int>(bb >> 56);
+#endif
+}
+
+// Index of the least significant set bit. bb must not be empty.
+inline int lsb(Bitboard bb) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bb);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, bb);
+    return static_cast<int>(index);
+#else
+    // De Bruijn bitscan (Kim Walisch, 2012).
+    constexpr int index64[64]{
+        0, 47,  1, 56, 48, 27,  2, 60, 57, 49, 41, 37, 28, 16,  3, 61,
+       54, 58, 35, 52, 50, 42, 21, 44, 38, 32, 29, 23, 17, 11,  4, 62,
+       46, 55, 26, 59, 40, 36, 15, 53, 34, 51, 20, 43, 31, 22, 10, 45,
+       25, 39, 14, 33, 19, 30,  9, 24, 13, 18,  8, 12,  7,  6,  5, 63
+    };
+    return index64[((bb ^ (bb - 1)) * 0x03f79d71b4cb0a89ULL) >> 58];
+#endif
+}
+
+// Index of the most significant set bit. bb must not be empty.
+inline int msb(Bitboard bb) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(bb);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, bb);
+    return static_cast<int>(index);
+#else
+    int index{ 0 };
+    while (bb >>= 1)
+        index++;
+    return index;
+#endif
+}
+
+#if defined(USE_PEXT)
+// Gathers the bits of bb selected by mask into the low bits of the result.
+inline Bitboard pext(Bitboard bb, Bitboard mask) {
+    return _pext_u64(bb, mask);
+}
+#endif
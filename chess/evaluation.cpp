@@ -1,41 +1,78 @@
 #include "evaluation.h"
+#include <algorithm>
 
-int countOnes(Bitboard n)
+int materialEval(const Position& pos)
 {
-    n -= (n >> 1) & 0x5555555555555555llu;
-    n = ((n >> 2) & 0x3333333333333333llu) + (n & 0x3333333333333333llu);
-    n = ((((n >> 4) + n) & 0x0F0F0F0F0F0F0F0Fllu)
-        * 0x0101010101010101) >> 56;
-    return n;
+    // Material and piece-square score in centipawns from white's point of
+    // view, blended between the midgame and endgame totals by game phase.
+    // Position keeps the totals up to date, so this is a few loads.
+    // Draws by repetition and the fifty-move rule are detected by the search.
+    const int phase{ std::min(pos.phase, MAX_PHASE) };
+    return (pos.psqtMg * phase + pos.psqtEg * (MAX_PHASE - phase)) / MAX_PHASE;
 }
 
-int materialEval(Position& pos)
+static void evaluatePieces(const Position& pos, const PawnEntry& pawns, Colour co, int& mg, int& eg)
 {
-    if (pos.fiftyMoveNum >= 50)
-        return DRAW_EVALUATION * (!pos.sideToMove==WHITE) - 2 * DRAW_EVALUATION * (!pos.sideToMove == BLACK);
-    bool second_repetition=false;
-    for (int i = pos.hashes.size() - 1; i >= 0; i--)
-    {
-        second_repetition = false;
-        for (int j = i - 1; j >= 0; j--)
-        {
-            //std::cout << "\ni : " << pos.hashes[i] << "\nj : " << pos.hashes[j] << std::endl;
-            if (pos.hashes[i] == pos.hashes[j])
-            {
-                if (second_repetition)
-                    return DRAW_EVALUATION * ((!pos.sideToMove == WHITE) - 2 * (!pos.sideToMove == BLACK));
-                else second_repetition = true;
+    // Mobility of the minor and major pieces, knight outposts, and attacks on
+    // the zone around the enemy king.
+    const Bitboard mobilityArea{ ~pos.bbByColour[co] & ~pawns.attacks[!co] };
+    // Squares in the enemy half that are defended by a pawn and can never be
+    // attacked by an enemy pawn.
+    const Bitboard outposts{ (co == WHITE ? OUTPOST_RANKS_WHITE : OUTPOST_RANKS_BLACK)
+                             & pawns.attacks[co] & ~pawns.attackSpans[!co] };
+    const int enemyKing{ lsb(pos.bbByType[KING] & pos.bbByColour[!co]) };
+    const Bitboard kingZone{ kingAttacks[enemyKing] | (1ULL << enemyKing) };
+    int attackers{ 0 };
+    int attackUnits{ 0 };
+    for (int pt = KNIGHT; pt <= QUEEN; pt++) {
+        for (Bitboard bb = pos.bbByType[pt] & pos.bbByColour[co]; bb; bb &= bb - 1) {
+            const Square sq{ static_cast<Square>(lsb(bb)) };
+            Bitboard attacks{ 0 };
+            switch (pt) {
+            case KNIGHT: attacks = knightAttacks[sq]; break;
+            case BISHOP: attacks = bishopAttacks(sq, pos.occupancy); break;
+            case ROOK:   attacks = rookAttacks(sq, pos.occupancy); break;
+            default:     attacks = queenAttacks(sq, pos.occupancy); break;
+            }
+            if (pt == KNIGHT && (outposts & (1ULL << sq))) {
+                mg += KNIGHT_OUTPOST_MG;
+                eg += KNIGHT_OUTPOST_EG;
+            }
+            const int mobility{ popCount(attacks & mobilityArea) - MOBILITY_BASE[pt] };
+            mg += MOBILITY_MG[pt] * mobility;
+            eg += MOBILITY_EG[pt] * mobility;
+            if (attacks & kingZone) {
+                attackers++;
+                attackUnits += KING_ATTACK_WEIGHTS[pt] * popCount(attacks & kingZone);
             }
         }
-        
     }
-    int res = countOnes(pos.bbByType[PAWN] & pos.bbByColour[WHITE]) - countOnes(pos.bbByType[PAWN] & pos.bbByColour[BLACK]) +
-        3 * (countOnes(pos.bbByType[KNIGHT] & pos.bbByColour[WHITE]) - countOnes(pos.bbByType[KNIGHT] & pos.bbByColour[BLACK])) +
-        3 * (countOnes(pos.bbByType[BISHOP] & pos.bbByColour[WHITE]) - countOnes(pos.bbByType[BISHOP] & pos.bbByColour[BLACK])) +
-        5 * (countOnes(pos.bbByType[ROOK] & pos.bbByColour[WHITE]) - countOnes(pos.bbByType[ROOK] & pos.bbByColour[BLACK])) +
-        9 * (countOnes(pos.bbByType[QUEEN] & pos.bbByColour[WHITE]) - countOnes(pos.bbByType[QUEEN] & pos.bbByColour[BLACK]));
-        
-    return res;
+    if (attackers >= 2)
+        mg += std::min(attackUnits * attackUnits / 4, MAX_KING_DANGER);
+}
+
+int evaluate(const Position& pos, PawnTable& pawnTable)
+{
+    const PawnEntry& pawns{ pawnTable.probe(pos) };
+    int mg{ pos.psqtMg + pawns.mg };
+    int eg{ pos.psqtEg + pawns.eg };
+    int mgBlack{ 0 };
+    int egBlack{ 0 };
+    evaluatePieces(pos, pawns, WHITE, mg, eg);
+    evaluatePieces(pos, pawns, BLACK, mgBlack, egBlack);
+    mg -= mgBlack;
+    eg -= egBlack;
+    const int phase{ std::min(pos.phase, MAX_PHASE) };
+    const int eval{ (mg * phase + eg * (MAX_PHASE - phase)) / MAX_PHASE };
+    return pos.sideToMove == WHITE ? eval : -eval;
+}
+
+int evaluate(const Position& pos, int alpha, int beta, PawnTable& pawnTable)
+{
+    const int material{ pos.sideToMove == WHITE ? materialEval(pos) : -materialEval(pos) };
+    if (material + LAZY_EVAL_MARGIN <= alpha || material - LAZY_EVAL_MARGIN >= beta)
+        return material;
+    return evaluate(pos, pawnTable);
 }
 
 //void play_console(int depth,Colour co, Position& pos)
@@ -1,12 +1,60 @@
 #pragma once
+#include <array>
 #include "position.h"
 #include "move.h"
+#include "bitops.h"
+#include "magic.h"
+#include "pawns.h"
 
 const int DRAW_EVALUATION = -2;
 const int CHECKMATE_EVALUATION = 10000;
+// Centipawn values indexed by PieceType.
+constexpr std::array<int, NUM_PIECE_TYPES> PIECE_VALUES{ 100, 300, 300, 500, 900, 0 };
 
-int countOnes(Bitboard n);
+// === Evaluation terms ===
+// Every term has a midgame (MG) and an endgame (EG) value; the totals are
+// blended by game phase (see psqt.h).
 
-int materialEval(Position& pos);
+// Mobility: bonus per square a piece can move to, counted from a typical
+// number of squares so that mobility doesn't inflate piece values. Squares
+// taken by own pieces or attacked by enemy pawns don't count.
+constexpr int MOBILITY_MG[NUM_PIECE_TYPES]{ 0, 4, 5, 2, 1, 0 };
+constexpr int MOBILITY_EG[NUM_PIECE_TYPES]{ 0, 4, 5, 4, 2, 0 };
+constexpr int MOBILITY_BASE[NUM_PIECE_TYPES]{ 0, 4, 7, 7, 14, 0 };
+
+// Pawn structure, per pawn. Passed pawn bonuses are indexed by rank as seen
+// by the pawn's owner.
+constexpr int DOUBLED_PAWN_MG{ -10 };
+constexpr int DOUBLED_PAWN_EG{ -20 };
+constexpr int ISOLATED_PAWN_MG{ -10 };
+constexpr int ISOLATED_PAWN_EG{ -15 };
+constexpr int PASSED_PAWN_MG[8]{ 0, 5, 10, 15, 25, 40, 60, 0 };
+constexpr int PASSED_PAWN_EG[8]{ 0, 10, 15, 30, 50, 80, 120, 0 };
+
+// Knight outposts: a knight on ranks 4-6 (seen from its side) defended by
+// a pawn, on a square no enemy pawn can ever attack.
+constexpr Bitboard OUTPOST_RANKS_WHITE{ 0x0000FFFFFF000000ULL };
+constexpr Bitboard OUTPOST_RANKS_BLACK{ 0x000000FFFFFF0000ULL };
+constexpr int KNIGHT_OUTPOST_MG{ 20 };
+constexpr int KNIGHT_OUTPOST_EG{ 10 };
+
+// King safety: a piece attacking squares next to the enemy king adds its
+// weight in attack units per square. With two or more attackers the king's
+// side loses units^2 / 4 centipawns in the midgame, up to the maximum.
+constexpr int KING_ATTACK_WEIGHTS[NUM_PIECE_TYPES]{ 0, 2, 2, 3, 5, 0 };
+constexpr int MAX_KING_DANGER{ 500 };
+
+// Lazy evaluation: if material and piece-square score alone are this far
+// outside the alpha-beta window, the other terms can't bring it back.
+constexpr int LAZY_EVAL_MARGIN{ 500 };
+
+// Tapered material + piece-square score from white's point of view.
+int materialEval(const Position& pos);
+// Static evaluation in centipawns from the point of view of the side to move.
+// Pawn structure comes from the calling thread's pawn table.
+int evaluate(const Position& pos, PawnTable& pawnTable);
+// As above, but returns the material + piece-square score alone when that is
+// already far outside the (alpha, beta) window.
+int evaluate(const Position& pos, int alpha, int beta, PawnTable& pawnTable);
 
 //void play_console(int depth,Colour co, Position& pos);
\ No newline at end of file
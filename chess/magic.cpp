@@ -0,0 +1,56 @@
+#include "magic.h"
+#include <stdexcept>
+#include <string>
+
+std::array<Bitboard, 5248> bishopTable{};
+std::array<Bitboard, 102400> rookTable{};
+std::array<std::array<Bitboard, NUM_SQUARES>, NUM_SQUARES> betweenMasks{};
+std::array<std::array<Bitboard, NUM_SQUARES>, NUM_SQUARES> lineMasks{};
+
+template <size_t N>
+static void fillSliderTable(std::array<Bitboard, N>& table, const std::array<Magic, NUM_SQUARES>& magics,
+                            const int (&directions)[4][2])
+{
+    for (int sq = 0; sq < NUM_SQUARES; sq++) {
+        const Magic& m = magics[sq];
+        // Carry-Rippler trick to enumerate all subsets of the mask.
+        Bitboard b{ 0 };
+        do {
+            const Bitboard attacks{ slidingAttacks(directions, sq, b) };
+            Bitboard& slot = table[m.offset + m.index(b)];
+            // Sliders always attack at least one square, so 0 marks a free slot.
+            if (slot && slot != attacks)
+                throw std::runtime_error("Bad magic number for square " + std::to_string(sq));
+            slot = attacks;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+    }
+}
+
+static void fillLineMasks()
+{
+    for (int a = 0; a < NUM_SQUARES; a++) {
+        for (int b = 0; b < NUM_SQUARES; b++) {
+            const Bitboard bbA{ 1ULL << a };
+            const Bitboard bbB{ 1ULL << b };
+            if (a != b && (rookAttacks(a, 0) & bbB)) {
+                lineMasks[a][b] = (rookAttacks(a, 0) & rookAttacks(b, 0)) | bbA | bbB;
+                betweenMasks[a][b] = rookAttacks(a, bbB) & rookAttacks(b, bbA);
+            }
+            else if (a != b && (bishopAttacks(a, 0) & bbB)) {
+                lineMasks[a][b] = (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | bbA | bbB;
+                betweenMasks[a][b] = bishopAttacks(a, bbB) & bishopAttacks(b, bbA);
+            }
+        }
+    }
+}
+
+// Runs before main(). No other static initialiser uses the slider tables.
+static const bool sliderTablesFilled = [] {
+    static_assert(bishopMagics[63].offset + (1U << (64 - bishopMagics[63].shift)) == 5248, "bishop table size");
+    static_assert(rookMagics[63].offset + (1U << (64 - rookMagics[63].shift)) == 102400, "rook table size");
+    fillSliderTable(bishopTable, bishopMagics, BISHOP_DIRECTIONS);
+    fillSliderTable(rookTable, rookMagics, ROOK_DIRECTIONS);
+    fillLineMasks();
+    return true;
+}();
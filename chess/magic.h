@@ -0,0 +1,138 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "bitboard.h"
+#include "bitboard_lookup.h"
+#include "bitops.h"
+
+// === magic.h ===
+// Sliding piece attacks with "fancy" magic bitboards: every square has its own
+// slice of a shared attack table, and the relevant blockers are hashed into an
+// index by a multiply and shift.
+// If the build uses PEXT (see bitops.h), the index is computed with it instead
+// and no magic numbers are needed.
+
+struct Magic {
+    Bitboard mask{ 0 };      // relevant blockers, board edges excluded
+    Bitboard magic{ 0 };
+    unsigned offset{ 0 };    // start of this square's slice of the table
+    unsigned shift{ 0 };
+
+    unsigned index(Bitboard occupancy) const {
+#if defined(USE_PEXT)
+        return static_cast<unsigned>(pext(occupancy, mask));
+#else
+        return static_cast<unsigned>(((occupancy & mask) * magic) >> shift);
+#endif
+    }
+};
+
+// Magic multipliers, found offline by trying sparse random numbers until one
+// mapped every blocker subset of a square without destructive collisions.
+constexpr Bitboard BISHOP_MAGIC_NUMBERS[NUM_SQUARES]{
+    0x40106000A1160020ULL, 0x0020010250810120ULL, 0x2010010220280081ULL, 0x002806004050C040ULL,
+    0x0002021018000000ULL, 0x2001112010000400ULL, 0x0881010120218080ULL, 0x1030820110010500ULL,
+    0x0000120222042400ULL, 0x2000020404040044ULL, 0x8000480094208000ULL, 0x0003422A02000001ULL,
+    0x000A220210100040ULL, 0x8004820202226000ULL, 0x0018234854100800ULL, 0x0100004042101040ULL,
+    0x0004001004082820ULL, 0x0010000810010048ULL, 0x1014004208081300ULL, 0x2080818802044202ULL,
+    0x0040880C00A00100ULL, 0x0080400200522010ULL, 0x0001000188180B04ULL, 0x0080249202020204ULL,
+    0x1004400004100410ULL, 0x00013100A0022206ULL, 0x2148500001040080ULL, 0x4241080011004300ULL,
+    0x4020848004002000ULL, 0x10101380D1004100ULL, 0x0008004422020284ULL, 0x01010A1041008080ULL,
+    0x0808080400082121ULL, 0x0808080400082121ULL, 0x0091128200100C00ULL, 0x0202200802010104ULL,
+    0x8C0A020200440085ULL, 0x01A0008080B10040ULL, 0x0889520080122800ULL, 0x100902022202010AULL,
+    0x04081A0816002000ULL, 0x0000681208005000ULL, 0x8170840041008802ULL, 0x0A00004200810805ULL,
+    0x0830404408210100ULL, 0x2602208106006102ULL, 0x1048300680802628ULL, 0x2602208106006102ULL,
+    0x0602010120110040ULL, 0x0941010801043000ULL, 0x000040440A210428ULL, 0x0008240020880021ULL,
+    0x0400002012048200ULL, 0x00AC102001210220ULL, 0x0220021002009900ULL, 0x84440C080A013080ULL,
+    0x0001008044200440ULL, 0x0004C04410841000ULL, 0x2000500104011130ULL, 0x1A0C010011C20229ULL,
+    0x0044800112202200ULL, 0x0434804908100424ULL, 0x0300404822C08200ULL, 0x48081010008A2A80ULL
+};
+
+constexpr Bitboard ROOK_MAGIC_NUMBERS[NUM_SQUARES]{
+    0x0880004000108025ULL, 0x8040004010002008ULL, 0x2080200010008008ULL, 0x1100100008210004ULL,
+    0xC200209084020008ULL, 0x2100010004000208ULL, 0x0400081000822421ULL, 0x0200010422048844ULL,
+    0x0800800080400024ULL, 0x0001402000401000ULL, 0x3000801000802001ULL, 0x4400800800100083ULL,
+    0x0904802402480080ULL, 0x4040800400020080ULL, 0x0018808042000100ULL, 0x4040800080004100ULL,
+    0x0040048001458024ULL, 0x00A0004000205000ULL, 0x3100808010002000ULL, 0x4825010010000820ULL,
+    0x5004808008000401ULL, 0x2024818004000A00ULL, 0x0005808002000100ULL, 0x2100060004806104ULL,
+    0x0080400880008421ULL, 0x4062220600410280ULL, 0x010A004A00108022ULL, 0x0000100080080080ULL,
+    0x0021000500080010ULL, 0x0044000202001008ULL, 0x0000100400080102ULL, 0xC020128200040545ULL,
+    0x0080002000400040ULL, 0x0000804000802004ULL, 0x0000120022004080ULL, 0x010A386103001001ULL,
+    0x9010080080800400ULL, 0x8440020080800400ULL, 0x0004228824001001ULL, 0x000000490A000084ULL,
+    0x0080002000504000ULL, 0x200020005000C000ULL, 0x0012088020420010ULL, 0x0010010080080800ULL,
+    0x0085001008010004ULL, 0x0002000204008080ULL, 0x0040413002040008ULL, 0x0000304081020004ULL,
+    0x0080204000800080ULL, 0x3008804000290100ULL, 0x1010100080200080ULL, 0x2008100208028080ULL,
+    0x5000850800910100ULL, 0x8402019004680200ULL, 0x0120911028020400ULL, 0x0000008044010200ULL,
+    0x0020850200244012ULL, 0x0020850200244012ULL, 0x0000102001040841ULL, 0x140900040A100021ULL,
+    0x000200282410A102ULL, 0x000200282410A102ULL, 0x000200282410A102ULL, 0x4048240043802106ULL
+};
+
+constexpr int BISHOP_DIRECTIONS[4][2]{ { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+constexpr int ROOK_DIRECTIONS[4][2]{ { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+// Slow reference attacks, walking each ray until it hits a blocker.
+constexpr Bitboard slidingAttacks(const int (&directions)[4][2], int sq, Bitboard occupancy) {
+    Bitboard attacks{ 0 };
+    for (int d = 0; d < 4; d++) {
+        int file{ sq % 8 + directions[d][0] };
+        int rank{ sq / 8 + directions[d][1] };
+        while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+            Bitboard bb{ 1ULL << (rank * 8 + file) };
+            attacks |= bb;
+            if (occupancy & bb)
+                break;
+            file += directions[d][0];
+            rank += directions[d][1];
+        }
+    }
+    return attacks;
+}
+
+constexpr std::array<Magic, NUM_SQUARES> makeMagics(const Bitboard (&magicNumbers)[NUM_SQUARES], const int (&directions)[4][2]) {
+    constexpr Bitboard RANK_1_8{ 0xFF000000000000FFULL };
+    constexpr Bitboard FILE_A_H{ 0x8181818181818181ULL };
+    std::array<Magic, NUM_SQUARES> magics{};
+    unsigned offset{ 0 };
+    for (int sq = 0; sq < NUM_SQUARES; sq++) {
+        const Bitboard edges{ (RANK_1_8 & ~(0xFFULL << (8 * (sq / 8))))
+                            | (FILE_A_H & ~(0x0101010101010101ULL << (sq % 8))) };
+        Magic& m = magics[sq];
+        m.mask = slidingAttacks(directions, sq, 0) & ~edges;
+        m.magic = magicNumbers[sq];
+        m.offset = offset;
+        int bits{ 0 };
+        for (Bitboard b = m.mask; b; b &= b - 1)
+            bits++;
+        m.shift = 64 - bits;
+        offset += 1U << bits;
+    }
+    return magics;
+}
+
+// The magic descriptors are built at compile time. The attack tables
+// themselves (about 840 KB) are too large for constant evaluation and are
+// filled in magic.cpp during static initialisation, before main().
+inline constexpr std::array<Magic, NUM_SQUARES> bishopMagics{ makeMagics(BISHOP_MAGIC_NUMBERS, BISHOP_DIRECTIONS) };
+inline constexpr std::array<Magic, NUM_SQUARES> rookMagics{ makeMagics(ROOK_MAGIC_NUMBERS, ROOK_DIRECTIONS) };
+
+// Sizes: sum over squares of 2^(number of relevant blockers).
+extern std::array<Bitboard, 5248> bishopTable;
+extern std::array<Bitboard, 102400> rookTable;
+
+// Squares strictly between two squares on a common rank, file or diagonal,
+// and the whole line through them; both are empty if the squares aren't
+// aligned. Filled together with the attack tables.
+extern std::array<std::array<Bitboard, NUM_SQUARES>, NUM_SQUARES> betweenMasks;
+extern std::array<std::array<Bitboard, NUM_SQUARES>, NUM_SQUARES> lineMasks;
+
+inline Bitboard bishopAttacks(int sq, Bitboard occupancy) {
+    return bishopTable[bishopMagics[sq].offset + bishopMagics[sq].index(occupancy)];
+}
+
+inline Bitboard rookAttacks(int sq, Bitboard occupancy) {
+    return rookTable[rookMagics[sq].offset + rookMagics[sq].index(occupancy)];
+}
+
+inline Bitboard queenAttacks(int sq, Bitboard occupancy) {
+    return bishopAttacks(sq, occupancy) | rookAttacks(sq, occupancy);
+}
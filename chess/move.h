@@ -3,7 +3,8 @@
 #pragma once
 #include <iostream>
 #include <cstdint>
-#include <vector>
+#include <cstddef>
+#include <utility>
 #include "bitboard_lookup.h"
 
 enum PieceType : int {
@@ -12,7 +13,6 @@ enum PieceType : int {
 };
 
 typedef uint16_t Move;
-typedef std::vector<Move> Movelist;
 enum MoveSpecial {
     MV_NORMAL, MV_PROMOTION, MV_CASTLING, MV_ENPASSANT
 };
@@ -78,6 +78,51 @@ inline Move buildEnPassant(Square fromSq, Square toSq) {
 }
 
 
+// === Movelist ===
+// Fixed-capacity list of moves living on the stack, so move generation never
+// touches the heap. No legal chess position has more than 218 moves.
+// Each move carries an optional score slot for move ordering.
+constexpr size_t MAX_MOVES{ 256 };
+
+class Movelist {
+public:
+    // Deliberately leaves the arrays uninitialised.
+    Movelist() : count(0) {}
+
+    void push_back(Move mv) { moves[count++] = mv; }
+    void clear() { count = 0; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    Move& operator[](size_t i) { return moves[i]; }
+    const Move& operator[](size_t i) const { return moves[i]; }
+    int& score(size_t i) { return scores[i]; }
+    int score(size_t i) const { return scores[i]; }
+
+    Move* begin() { return moves; }
+    Move* end() { return moves + count; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
+
+    // Swaps two moves together with their scores.
+    void swap(size_t i, size_t j) {
+        std::swap(moves[i], moves[j]);
+        std::swap(scores[i], scores[j]);
+    }
+    // Removes a move by moving the last one into its place. Does not keep
+    // the order of the list.
+    void removeAt(size_t i) {
+        --count;
+        moves[i] = moves[count];
+        scores[i] = scores[count];
+    }
+
+private:
+    Move moves[MAX_MOVES];
+    int scores[MAX_MOVES];
+    size_t count;
+};
+
 // Conversion to string for debugging
 inline std::string toString(Move mv) {
     if (mv == 0) { return "-----  "; }
@@ -104,21 +149,20 @@ inline std::string toString(Move mv) {
     return outStr;
 }
 
+// UCI long algebraic notation: "e2e4", "e7e8q". Castling is encoded as king
+// takes rook, but UCI sends the king's own move ("e1g1").
 inline std::string toStringUCI(Move mv) {
     if (mv == 0) { return ""; }
     std::string outStr;
     outStr.push_back('a' + (mv & 7));
     outStr.push_back('1' + ((mv >> 3) & 7));
-    outStr.push_back('a' + ((mv >> 6) & 7));
+    int toFile{ (mv >> 6) & 7 };
+    if (isCastling(mv))
+        toFile = toFile > (mv & 7) ? 6 : 2;     // g-file or c-file
+    outStr.push_back('a' + toFile);
     outStr.push_back('1' + ((mv >> 9) & 7));
-    if (outStr == "e1h1")
-        outStr = "e1g1";
-    else if (outStr == "e1a1")
-        outStr = "e1c1";
-    else if (outStr == "e8h8")
-        outStr = "e8g8";
-    else if (outStr == "e8a8")
-        outStr = "e8c8";
+    if (isPromotion(mv))
+        outStr.push_back("pnbrqk"[getPromotionType(mv)]);
     return outStr;
 }
 
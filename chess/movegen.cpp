@@ -1,204 +1,191 @@
 #include "movegen.h"
-#include <vector>
-#include <future>
 
-Movelist generateLegalMoves(Position& pos)
+// Generates only legal moves. Checkers and pinned pieces are found once;
+// every non-king move must then land in the check mask, and a pinned piece
+// must stay on the line through its king. King moves are tested against the
+// attackers with the king lifted off the board, and en passant is verified in
+// addPawnAttacks. With capturesOnly, only captures and promotions are added.
+static void generateLegal(Movelist& mvlist, const Position& pos, bool capturesOnly)
 {
-    if (pos.gameover)
-        return Movelist{};
-    Colour co{ pos.sideToMove };
-    Movelist mvlist{};
-    // Start generating valid moves.
-    int i = 0;
-    //std::cout<<pos.pretty_cb();
-    addKingMoves(mvlist, pos);
-    addKnightMoves(mvlist, pos);
-    addBishopMoves(mvlist, pos);
-    addRookMoves(mvlist, pos);
-    addQueenMoves(mvlist, pos);
-    addPawnMoves(mvlist, pos);
-    addPawnAttacks(mvlist, pos);
-    addCastlingMoves(mvlist, pos);
-    // Test for checks.
-    for (auto it = mvlist.begin(); it != mvlist.end();) {
-        if (isLegal(*it, pos)) {
-            ++it;
-        }
-        else {
-            it = mvlist.erase(it);
-        }
+    const Colour us{ pos.sideToMove };
+    const Square ksq{ static_cast<Square>(lsb(pos.bbByType[KING] & pos.bbByColour[us])) };
+    const Bitboard checkers{ attacksTo(ksq, !us, pos) };
+    const Bitboard destinations{ capturesOnly ? pos.bbByColour[!us] : ~0ULL };
+
+    // King moves: a square is safe if no enemy attacks it once the king has
+    // left its current square (so it can't step back along a checking ray).
+    Bitboard kingTargets{ kingAttacks[ksq] & ~pos.bbByColour[us] & destinations };
+    const Bitboard occupancyNoKing{ pos.occupancy ^ (1ULL << ksq) };
+    for (Bitboard bb = kingTargets; bb; bb &= bb - 1) {
+        const Square sq{ static_cast<Square>(lsb(bb)) };
+        if (attacksTo(sq, !us, pos, occupancyNoKing))
+            kingTargets ^= 1ULL << sq;
     }
-    if (mvlist.empty())
-        pos.gameover=true;
-    return mvlist;
+    addKingMoves(mvlist, pos, kingTargets);
+
+    // In double check only the king can move.
+    if (checkers & (checkers - 1))
+        return;
+    Bitboard targets{ ~0ULL };
+    if (checkers)
+        targets = betweenMasks[ksq][lsb(checkers)] | checkers;
+    const Bitboard pinned{ pinnedPieces(us, pos) };
+    addKnightMoves(mvlist, pos, targets & destinations, pinned);
+    addBishopMoves(mvlist, pos, targets & destinations, pinned);
+    addRookMoves(mvlist, pos, targets & destinations, pinned);
+    addQueenMoves(mvlist, pos, targets & destinations, pinned);
+    addPawnAttacks(mvlist, pos, targets & destinations, pinned);
+    if (capturesOnly) {
+        // Pushes onto the last rank.
+        addPawnMoves(mvlist, pos, targets & (us == WHITE ? RANK_8 : RANK_1), pinned);
+        return;
+    }
+    addPawnMoves(mvlist, pos, targets, pinned);
+    if (!checkers)
+        addCastlingMoves(mvlist, pos);
 }
 
-bool isInCheck(Colour co, const Position& pos)
+Movelist generateLegalMoves(const Position& pos)
 {
-    // Test if a side (colour) is in check.
-    Bitboard bb{ pos.bbByType[KING] & pos.bbByColour[co]};
-    Square sq{ static_cast<Square>(leastSignificantBit(bb)) }; // assumes exactly one king per side.
-    return isAttacked(sq, !co, pos);
+    Movelist mvlist;
+    generateLegal(mvlist, pos, false);
+    return mvlist;
 }
 
-bool isLegal(Move mv, Position& pos)
+Movelist generateLegalCaptures(const Position& pos)
 {
-    // Test if making a move would leave one's own royalty in check.
-    // Assumes move is valid.
-    // For eventual speedup logic can be improved from naive make-unmake-make.
-    pos.makeMove(mv);
-    bool isSuicide{ isInCheck(!(pos.sideToMove), pos) };
-    pos.unmakeMove(mv);
-    return !isSuicide;
+    Movelist mvlist;
+    generateLegal(mvlist, pos, true);
+    return mvlist;
 }
 
-uint64_t perft(int depth, Position& pos)
+Bitboard pinnedPieces(Colour co, const Position& pos)
 {
-    // Recursive function to count all legal moves (nodes) at depth n.
-    uint64_t nodes = 0;
-    // Terminating condition
-    if (depth == 0) { return 1; }
-    //std::cout << pos.pretty_cb();
-    Movelist mvlist = generateLegalMoves(pos);
-    int sz = mvlist.size();
-    // Recurse.
-    for (int i = 0; i < sz; ++i) {
-        pos.makeMove(mvlist[i]);
-        if (!isInCheck(!pos.sideToMove,pos))
-        {
-           /* int N= perft(depth - 1, pos);
-            nodes += N;*/
-            nodes += perft(depth - 1, pos);
-           /*if (depth == 1)
-           {
-                std::cout << toString(mvlist[i]) << "  " << N<<std::endl;
-           }*/
-        }
-        pos.unmakeMove(mvlist[i]);
-        
+    // A piece is pinned if it is the only piece between its king and an enemy
+    // slider that would otherwise attack the king.
+    const Square ksq{ static_cast<Square>(lsb(pos.bbByType[KING] & pos.bbByColour[co])) };
+    Bitboard snipers{ ((rookAttacks(ksq, 0) & (pos.bbByType[ROOK] | pos.bbByType[QUEEN]))
+                     | (bishopAttacks(ksq, 0) & (pos.bbByType[BISHOP] | pos.bbByType[QUEEN])))
+                     & pos.bbByColour[!co] };
+    Bitboard pinned{ 0 };
+    while (snipers) {
+        const Bitboard blockers{ betweenMasks[ksq][lsb(snipers)] & pos.occupancy };
+        snipers &= snipers - 1;
+        if (blockers && !(blockers & (blockers - 1)))
+            pinned |= blockers & pos.bbByColour[co];
     }
-    return nodes;
+    return pinned;
 }
 
-uint64_t perft_parallel(int depth, Position& pos)
+bool isInCheck(Colour co, const Position& pos)
 {
-    // Recursive function to count all legal moves (nodes) at depth n.
-
-    // Terminating condition
-    if (depth == 0) { return 1; }
-    Movelist mvlist = generateLegalMoves(pos);
-    int sz = mvlist.size();
-
-    std::vector<std::future<uint64_t>> futures;  //   
-
-    for (int i = 0; i < sz; ++i) {
-        Position pos_copy(pos);
-        pos_copy.makeMove(mvlist[i]);
-        futures.emplace_back(std::async(std::launch::async, [depth, pos_copy]() {
-            if (!isInCheck(!pos_copy.sideToMove, pos_copy)) {
-                return perft(depth - 1, const_cast<Position&>(pos_copy));
-            }
-            return uint64_t(0);
-            }));
-    }
-    uint64_t total_nodes = 0;
-    for (auto& future : futures) {
-        total_nodes += future.get();  // ,    
-    }
-    return total_nodes;
+    // Test if a side (colour) is in check.
+    Bitboard bb{ pos.bbByType[KING] & pos.bbByColour[co]};
+    Square sq{ static_cast<Square>(lsb(bb)) }; // assumes exactly one king per side.
+    return isAttacked(sq, !co, pos);
 }
 
-void addKingMoves(Movelist& mvlist, const Position& pos) {
+void addKingMoves(Movelist& mvlist, const Position& pos, Bitboard targets) {
     Bitboard bbFrom{ pos.bbByType[KING] & pos.bbByColour[pos.sideToMove]};
     Square fromSq{ NO_SQ };
     Bitboard bbTo{ 0 };
-    fromSq = static_cast<Square>(leastSignificantBit(bbFrom));
-    bbTo = kingAttacks[fromSq] & ~pos.bbByColour[pos.sideToMove];
+    fromSq = static_cast<Square>(lsb(bbFrom));
+    bbTo = kingAttacks[fromSq] & ~pos.bbByColour[pos.sideToMove] & targets;
     Square destination{ NO_SQ };
     while (bbTo) {
-        destination = static_cast<Square>(leastSignificantBit(bbTo));
+        destination = static_cast<Square>(lsb(bbTo));
         bbTo &= bbTo - 1;
         mvlist.push_back(buildMove(fromSq, destination));
     }
 }
 
-void addKnightMoves(Movelist& mvlist, const Position& pos)
+void addKnightMoves(Movelist& mvlist, const Position& pos, Bitboard targets, Bitboard pinned)
 {
-    Bitboard bbFrom{ pos.bbByType[KNIGHT] & pos.bbByColour[pos.sideToMove] };
+    // A pinned knight can never stay on its pin line.
+    Bitboard bbFrom{ pos.bbByType[KNIGHT] & pos.bbByColour[pos.sideToMove] & ~pinned };
     Square fromSq{ NO_SQ };
     Bitboard bbTo{ 0 };
     Square destination{ NO_SQ };
     while (bbFrom) {
-        fromSq = static_cast<Square>(leastSignificantBit(bbFrom));
+        fromSq = static_cast<Square>(lsb(bbFrom));
         bbFrom &= bbFrom - 1;
-        bbTo = knightAttacks[fromSq] & ~pos.bbByColour[pos.sideToMove];
+        bbTo = knightAttacks[fromSq] & ~pos.bbByColour[pos.sideToMove] & targets;
         while (bbTo) {
-            destination = static_cast<Square>(leastSignificantBit(bbTo));
+            destination = static_cast<Square>(lsb(bbTo));
             bbTo &= bbTo - 1;
             mvlist.push_back(buildMove(fromSq, destination));
         }
     }
 }
 
-void addBishopMoves(Movelist& mvlist, const Position& pos)
+void addBishopMoves(Movelist& mvlist, const Position& pos, Bitboard targets, Bitboard pinned)
 {
     Bitboard bbFrom{ pos.bbByType[BISHOP] & pos.bbByColour[pos.sideToMove] };
+    const Square ksq{ static_cast<Square>(lsb(pos.bbByType[KING] & pos.bbByColour[pos.sideToMove])) };
     Square fromSq{ NO_SQ };
     Bitboard bbTo{ 0 };
     Square destination{ NO_SQ };
     while (bbFrom) {
-        fromSq = static_cast<Square>(leastSignificantBit(bbFrom));
+        fromSq = static_cast<Square>(lsb(bbFrom));
         bbFrom &= bbFrom - 1;
-        bbTo = (findDiagAttacks(fromSq,pos.occupancy) | findAntidiagAttacks(fromSq, pos.occupancy)) & ~pos.bbByColour[pos.sideToMove];
+        bbTo = bishopAttacks(fromSq, pos.occupancy) & ~pos.bbByColour[pos.sideToMove] & targets;
+        if (pinned & (1ULL << fromSq))
+            bbTo &= lineMasks[ksq][fromSq];
         while (bbTo) {
-            destination = static_cast<Square>(leastSignificantBit(bbTo));
+            destination = static_cast<Square>(lsb(bbTo));
             bbTo &= bbTo - 1;
             mvlist.push_back(buildMove(fromSq, destination));
         }
     }
 }
 
-void addRookMoves(Movelist& mvlist, const Position& pos)
+void addRookMoves(Movelist& mvlist, const Position& pos, Bitboard targets, Bitboard pinned)
 {
     Bitboard bbFrom{ pos.bbByType[ROOK] & pos.bbByColour[pos.sideToMove] };
+    const Square ksq{ static_cast<Square>(lsb(pos.bbByType[KING] & pos.bbByColour[pos.sideToMove])) };
     Square fromSq{ NO_SQ };
     Bitboard bbTo{ 0 };
     Square destination{ NO_SQ };
     while (bbFrom) {
-        fromSq = static_cast<Square>(leastSignificantBit(bbFrom));
+        fromSq = static_cast<Square>(lsb(bbFrom));
         bbFrom &= bbFrom - 1;
-        bbTo = (findFileAttacks(fromSq, pos.occupancy) | findRankAttacks(fromSq, pos.occupancy)) & ~pos.bbByColour[pos.sideToMove];
+        bbTo = rookAttacks(fromSq, pos.occupancy) & ~pos.bbByColour[pos.sideToMove] & targets;
+        if (pinned & (1ULL << fromSq))
+            bbTo &= lineMasks[ksq][fromSq];
         while (bbTo) {
-            destination = static_cast<Square>(leastSignificantBit(bbTo));
+            destination = static_cast<Square>(lsb(bbTo));
             bbTo &= bbTo - 1;
             mvlist.push_back(buildMove(fromSq, destination));
         }
     }
 }
 
-void addQueenMoves(Movelist& mvlist, const Position& pos)
+void addQueenMoves(Movelist& mvlist, const Position& pos, Bitboard targets, Bitboard pinned)
 {
     Bitboard bbFrom{ pos.bbByType[QUEEN] & pos.bbByColour[pos.sideToMove] };
+    const Square ksq{ static_cast<Square>(lsb(pos.bbByType[KING] & pos.bbByColour[pos.sideToMove])) };
     Square fromSq{ NO_SQ };
     Bitboard bbTo{ 0 };
     Square destination{ NO_SQ };
     while (bbFrom) {
-        fromSq = static_cast<Square>(leastSignificantBit(bbFrom));
+        fromSq = static_cast<Square>(lsb(bbFrom));
         bbFrom &= bbFrom - 1;
-        bbTo = (findFileAttacks(fromSq, pos.occupancy) | findRankAttacks(fromSq, pos.occupancy) |
-            findDiagAttacks(fromSq, pos.occupancy) | findAntidiagAttacks(fromSq, pos.occupancy)) & ~pos.bbByColour[pos.sideToMove];
+        bbTo = queenAttacks(fromSq, pos.occupancy) & ~pos.bbByColour[pos.sideToMove] & targets;
+        if (pinned & (1ULL << fromSq))
+            bbTo &= lineMasks[ksq][fromSq];
         while (bbTo) {
-            destination = static_cast<Square>(leastSignificantBit(bbTo));
+            destination = static_cast<Square>(lsb(bbTo));
             bbTo &= bbTo - 1;
             mvlist.push_back(buildMove(fromSq, destination));
         }
     }
 }
 
-void addPawnAttacks(Movelist& mvlist, const Position& pos)
+void addPawnAttacks(Movelist& mvlist, const Position& pos, Bitboard targets, Bitboard pinned)
 {
 
     Bitboard bbFrom{ pos.bbByType[PAWN] & pos.bbByColour[pos.sideToMove] };
+    const Square ksq{ static_cast<Square>(lsb(pos.bbByType[KING] & pos.bbByColour[pos.sideToMove])) };
     Square fromSq{ NO_SQ };
     Square destination{ NO_SQ };
     Bitboard bbTo{ 0 };
@@ -206,11 +193,14 @@ void addPawnAttacks(Movelist& mvlist, const Position& pos)
     if (pos.enPassantRights != NO_SQ)
         EnPassantBB = 1ULL << pos.enPassantRights;
     while (bbFrom) {
-        fromSq = static_cast<Square>(leastSignificantBit(bbFrom));
+        fromSq = static_cast<Square>(lsb(bbFrom));
         bbFrom &= bbFrom - 1;
-        bbTo = pawnAttacks[pos.sideToMove][fromSq] & pos.bbByColour[!pos.sideToMove] ;
+        Bitboard allowed{ targets };
+        if (pinned & (1ULL << fromSq))
+            allowed &= lineMasks[ksq][fromSq];
+        bbTo = pawnAttacks[pos.sideToMove][fromSq] & pos.bbByColour[!pos.sideToMove] & allowed;
         while (bbTo) {
-            destination = static_cast<Square>(leastSignificantBit(bbTo));
+            destination = static_cast<Square>(lsb(bbTo));
             bbTo &= bbTo - 1;
             if (destination >= 0 + 56 * (pos.sideToMove == WHITE) && destination <= 7 + 56 * (pos.sideToMove == WHITE))
             {
@@ -222,37 +212,51 @@ void addPawnAttacks(Movelist& mvlist, const Position& pos)
             else
                 mvlist.push_back(buildMove(fromSq, destination));
         }
-        if (bbTo = pawnAttacks[pos.sideToMove][fromSq] & EnPassantBB)
-            mvlist.push_back(buildEnPassant(fromSq, static_cast<Square>(leastSignificantBit(bbTo))));
+        if (bbTo = pawnAttacks[pos.sideToMove][fromSq] & EnPassantBB) {
+            // En passant removes two pieces from the same rank, which can
+            // uncover a slider the pin mask doesn't see, so test it directly.
+            destination = static_cast<Square>(lsb(bbTo));
+            const Bitboard bbCaptured{ 1ULL << (destination - 8 + 16 * (pos.sideToMove == BLACK)) };
+            const Bitboard occupancy{ pos.occupancy ^ (1ULL << fromSq) ^ bbCaptured ^ bbTo };
+            if (!(attacksTo(ksq, !pos.sideToMove, pos, occupancy) & ~bbCaptured))
+                mvlist.push_back(buildEnPassant(fromSq, destination));
+        }
     }
 }
 
-void addPawnMoves(Movelist& mvlist, const Position& pos)
+void addPawnMoves(Movelist& mvlist, const Position& pos, Bitboard targets, Bitboard pinned)
 {
     
     Bitboard bbFrom{ pos.bbByType[PAWN] & pos.bbByColour[pos.sideToMove]};
+    const Square ksq{ static_cast<Square>(lsb(pos.bbByType[KING] & pos.bbByColour[pos.sideToMove])) };
     Square toSq{ NO_SQ };
 
     while (bbFrom) {
-        Square fromSq = static_cast<Square>(leastSignificantBit(bbFrom));
+        Square fromSq = static_cast<Square>(lsb(bbFrom));
         bbFrom &= bbFrom - 1;
+        Bitboard allowed{ targets };
+        if (pinned & (1ULL << fromSq))
+            allowed &= lineMasks[ksq][fromSq];
         toSq = static_cast<Square>(fromSq + 8 - 16 * (pos.sideToMove == BLACK));
         if (((1ULL << toSq) & pos.occupancy) == 0)
         {
             if (fromSq >= 48 - 40 * (pos.sideToMove == BLACK) && fromSq <= 55 - 40 * (pos.sideToMove == BLACK))
             {
-                mvlist.push_back(buildPromotion(fromSq, toSq, KNIGHT));
-                mvlist.push_back(buildPromotion(fromSq, toSq, BISHOP));
-                mvlist.push_back(buildPromotion(fromSq, toSq, ROOK));
-                mvlist.push_back(buildPromotion(fromSq, toSq, QUEEN));
+                if (allowed & (1ULL << toSq)) {
+                    mvlist.push_back(buildPromotion(fromSq, toSq, KNIGHT));
+                    mvlist.push_back(buildPromotion(fromSq, toSq, BISHOP));
+                    mvlist.push_back(buildPromotion(fromSq, toSq, ROOK));
+                    mvlist.push_back(buildPromotion(fromSq, toSq, QUEEN));
+                }
             }
             else
             {
-                mvlist.push_back(buildMove(fromSq, toSq));
+                if (allowed & (1ULL << toSq))
+                    mvlist.push_back(buildMove(fromSq, toSq));
                 if (fromSq >= 8 + 40 * (pos.sideToMove == BLACK) && fromSq <= 15 + 40 * (pos.sideToMove == BLACK))
                 {
                     toSq = static_cast<Square>(fromSq + 16 - 32 * (pos.sideToMove == BLACK));
-                    if (((1ULL << toSq) & pos.occupancy) == 0)
+                    if (((1ULL << toSq) & pos.occupancy) == 0 && (allowed & (1ULL << toSq)))
                     {
                         mvlist.push_back(buildMove(fromSq, toSq));
                     }
@@ -315,7 +319,7 @@ bool isCastlingValid(CastlingRights cr, const Position& pos)
         pathMask ^= 0x0200000000000000;
     }
     while (pathMask) {
-        sq = static_cast<Square>(leastSignificantBit(pathMask));
+        sq = static_cast<Square>(lsb(pathMask));
         pathMask &= pathMask - 1;
         if (isAttacked(sq, !co, pos)) {
             return false;
@@ -363,14 +367,13 @@ Bitboard attacksFrom(Square sq, Colour co, PieceType pcty, const Position& pos)
         bbAttacked = knightAttacks[sq];
         break;
     case BISHOP:
-        bbAttacked = findDiagAttacks(sq, pos.occupancy) | findAntidiagAttacks(sq, pos.occupancy);
+        bbAttacked = bishopAttacks(sq, pos.occupancy);
         break;
     case ROOK:
-        bbAttacked = findRankAttacks(sq, pos.occupancy) | findFileAttacks(sq, pos.occupancy);
+        bbAttacked = rookAttacks(sq, pos.occupancy);
         break;
     case QUEEN:
-        bbAttacked = findRankAttacks(sq, pos.occupancy) | findFileAttacks(sq, pos.occupancy) |
-            findDiagAttacks(sq, pos.occupancy) | findAntidiagAttacks(sq, pos.occupancy);
+        bbAttacked = queenAttacks(sq, pos.occupancy);
         break;
     case KING:
         bbAttacked = kingAttacks[sq];
@@ -381,15 +384,21 @@ Bitboard attacksFrom(Square sq, Colour co, PieceType pcty, const Position& pos)
 
 Bitboard attacksTo(Square sq, Colour co, const Position& pos)
 {
-    // Returns bitboard of units of a given colour that attack a given square.
+    return attacksTo(sq, co, pos, pos.occupancy);
+}
+
+Bitboard attacksTo(Square sq, Colour co, const Position& pos, Bitboard occupancy)
+{
+    // Returns bitboard of units of a given colour that attack a given square,
+    // with sliders seeing through the supplied occupancy rather than the board's.
     // In chess, most piece types have the following property: if piece PC is on
     // square SQ_A attacking SQ_B, then from SQ_B it would attack SQ_A.
     Bitboard bbAttackers{ 0 };
     bbAttackers = kingAttacks[sq] & pos.bbByType[KING] & pos.bbByColour[co];
     bbAttackers |= knightAttacks[sq] & pos.bbByType[KNIGHT] & pos.bbByColour[co];
-    bbAttackers |= (findDiagAttacks(sq, pos.occupancy) | findAntidiagAttacks(sq, pos.occupancy))
+    bbAttackers |= bishopAttacks(sq, occupancy)
         & (pos.bbByType[BISHOP] | pos.bbByType[QUEEN]) & pos.bbByColour[co];
-    bbAttackers |= (findRankAttacks(sq, pos.occupancy) | findFileAttacks(sq, pos.occupancy))
+    bbAttackers |= rookAttacks(sq, occupancy)
         & (pos.bbByType[ROOK] | pos.bbByType[QUEEN]) & pos.bbByColour[co];
     // But for pawns, a square SQ_A is attacked by a [Colour] pawn on SQ_B,
     // if a [!Colour] pawn on SQ_A would attack SQ_B.
@@ -5,23 +5,30 @@
 #include "bitboard_lookup.h"
 #include "move.h"
 #include "position.h"
+#include "magic.h"
+#include "bitops.h"
 #include <cstdint>
 
-Movelist generateLegalMoves(Position& pos);
+// All legal moves. An empty list means checkmate or stalemate; telling them
+// apart, and detecting draws, is up to the caller.
+Movelist generateLegalMoves(const Position& pos);
+// Legal captures (including en passant) and promotions only, for the
+// quiescence search. Unlike generateLegalMoves, an empty list doesn't mean
+// the game is over.
+Movelist generateLegalCaptures(const Position& pos);
 bool isInCheck(Colour co, const Position& pos);
-bool isLegal(Move mv, Position& pos);
 
-uint64_t perft(int depth, Position& pos);
-uint64_t perft_parallel(int depth, Position& pos);
 // === Functions to generate particular types of valid moves ===
-void addKingMoves(Movelist& mvlist, const Position& pos);
-void addKnightMoves(Movelist& mvlist, const Position& pos);
-void addBishopMoves(Movelist& mvlist, const Position& pos);
-void addRookMoves(Movelist& mvlist, const Position& pos);
-void addQueenMoves(Movelist& mvlist, const Position& pos);
+// Destinations are limited to `targets` (the check mask); pieces in `pinned`
+// may only move along the line through their king.
+void addKingMoves(Movelist& mvlist, const Position& pos, Bitboard targets = ~0ULL);
+void addKnightMoves(Movelist& mvlist, const Position& pos, Bitboard targets = ~0ULL, Bitboard pinned = 0);
+void addBishopMoves(Movelist& mvlist, const Position& pos, Bitboard targets = ~0ULL, Bitboard pinned = 0);
+void addRookMoves(Movelist& mvlist, const Position& pos, Bitboard targets = ~0ULL, Bitboard pinned = 0);
+void addQueenMoves(Movelist& mvlist, const Position& pos, Bitboard targets = ~0ULL, Bitboard pinned = 0);
 
-void addPawnAttacks(Movelist& mvlist, const Position& pos);	//includes EnPassant
-void addPawnMoves(Movelist& mvlist, const Position& pos);
+void addPawnAttacks(Movelist& mvlist, const Position& pos, Bitboard targets = ~0ULL, Bitboard pinned = 0);	//includes EnPassant
+void addPawnMoves(Movelist& mvlist, const Position& pos, Bitboard targets = ~0ULL, Bitboard pinned = 0);
 
 bool isCastlingValid(CastlingRights cr, const Position& pos);
 void addCastlingMoves(Movelist& mvlist, const Position& pos);
@@ -29,6 +36,8 @@ void addCastlingMoves(Movelist& mvlist, const Position& pos);
 // === Useful auxiliary functions ===
 Bitboard attacksFrom(Square sq, Colour co, PieceType pcty, const Position& pos);
 Bitboard attacksTo(Square sq, Colour co, const Position& pos);
+Bitboard attacksTo(Square sq, Colour co, const Position& pos, Bitboard occupancy);
+Bitboard pinnedPieces(Colour co, const Position& pos);
 bool isAttacked(Square sq, Colour co, const Position& pos);
 
 #endif //#ifndef MOVEGEN_INCLUDED
@@ -0,0 +1,104 @@
+#include "movepick.h"
+#include <cstdlib>
+#include <cstring>
+#include "see.h"
+
+// Score bands, far enough apart that history scores never cross them.
+constexpr int TT_MOVE_SCORE{ 1 << 30 };
+constexpr int CAPTURE_SCORE{ 1 << 28 };
+constexpr int KILLER_SCORE{ 1 << 27 };
+constexpr int COUNTER_MOVE_SCORE{ 1 << 26 };
+// Captures that lose material go after all quiet moves.
+constexpr int BAD_CAPTURE_SCORE{ -(1 << 28) };
+
+void History::clear()
+{
+    std::memset(butterfly, 0, sizeof(butterfly));
+    std::memset(continuation, 0, sizeof(continuation));
+    std::memset(counterMoves, 0, sizeof(counterMoves));
+}
+
+void History::age()
+{
+    int16_t* b{ &butterfly[0][0][0] };
+    for (size_t i = 0; i < sizeof(butterfly) / sizeof(int16_t); i++)
+        b[i] /= 2;
+    int16_t* c{ &continuation[0][0][0][0][0] };
+    for (size_t i = 0; i < sizeof(continuation) / sizeof(int16_t); i++)
+        c[i] /= 2;
+}
+
+int History::quietScore(Colour us, Move mv, PieceTo moved, PieceTo prev) const
+{
+    int score{ butterfly[us][mv & 63][(mv >> 6) & 63] };
+    if (prev.piece != NO_TYPE)
+        score += continuation[us][prev.piece][prev.to][moved.piece][moved.to];
+    return score;
+}
+
+static void applyBonus(int16_t& entry, int bonus)
+{
+    entry += bonus - entry * std::abs(bonus) / HISTORY_MAX;
+}
+
+void History::update(Colour us, Move mv, PieceTo moved, PieceTo prev, int bonus)
+{
+    applyBonus(butterfly[us][mv & 63][(mv >> 6) & 63], bonus);
+    if (prev.piece != NO_TYPE)
+        applyBonus(continuation[us][prev.piece][prev.to][moved.piece][moved.to], bonus);
+}
+
+Move History::counterMove(Colour us, PieceTo prev) const
+{
+    return prev.piece == NO_TYPE ? Move(0) : counterMoves[us][prev.piece][prev.to];
+}
+
+void History::setCounterMove(Colour us, PieceTo prev, Move mv)
+{
+    if (prev.piece != NO_TYPE)
+        counterMoves[us][prev.piece][prev.to] = mv;
+}
+
+MovePicker::MovePicker(const Position& pos, Movelist& mvlist, Move ttMove, const Move* killers,
+    PieceTo prev, const History& history)
+    : moves(mvlist)
+{
+    const Colour us{ pos.sideToMove };
+    const Move counter{ history.counterMove(us, prev) };
+    for (size_t i = 0; i < moves.size(); i++) {
+        const Move mv{ moves[i] };
+        int& score{ moves.score(i) };
+        if (mv == ttMove) {
+            score = TT_MOVE_SCORE;
+        }
+        else if (isCapture(pos, mv) || (isPromotion(mv) && getPromotionType(mv) == QUEEN)) {
+            const PieceType victim{ isEnPassant(mv) ? PAWN : pos.mailbox[(mv >> 6) & 63] };
+            score = (seeGE(pos, mv, 0) ? CAPTURE_SCORE : BAD_CAPTURE_SCORE)
+                + (victim == NO_TYPE ? 0 : 8 * (victim + 1)) - pos.mailbox[mv & 63];
+            if (isPromotion(mv))
+                score += 8 * getPromotionType(mv);
+        }
+        else if (mv == killers[0] || mv == killers[1]) {
+            score = KILLER_SCORE + (mv == killers[0]);
+        }
+        else if (mv == counter) {
+            score = COUNTER_MOVE_SCORE;
+        }
+        else {
+            score = history.quietScore(us, mv, pieceTo(pos, mv), prev);
+        }
+    }
+}
+
+Move MovePicker::next()
+{
+    if (current >= moves.size())
+        return 0;
+    size_t best{ current };
+    for (size_t i = current + 1; i < moves.size(); i++) {
+        if (moves.score(i) > moves.score(best))
+            best = i;
+    }
+    moves.swap(current, best);
+    return moves[current++];
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include "position.h"
+#include "move.h"
+
+// === movepick.h ===
+// Move ordering. Alpha-beta cuts off sooner the earlier the best move is
+// tried, so moves are searched in this order:
+//   1. the hash move
+//   2. captures and queen promotions that don't lose material by static
+//      exchange evaluation, most valuable victim first and least valuable
+//      attacker next (MVV-LVA)
+//   3. the two killer moves of the ply (quiet moves that caused a cutoff in
+//      a sibling node)
+//   4. the counter move: the quiet reply that last refuted the opponent's
+//      previous move
+//   5. remaining quiet moves by history score
+//   6. losing captures, by MVV-LVA
+// Moves are scored once and picked by selection sort, so a node that cuts
+// off on its first move never pays for sorting the rest.
+
+// The piece that made a move and the square the move went to; what counter
+// moves and continuation history are keyed on. Castling is keyed as a king
+// move to the rook's square, as it is encoded.
+struct PieceTo {
+    PieceType piece{ NO_TYPE };
+    Square to{ NO_SQ };
+};
+
+inline bool isCapture(const Position& pos, Move mv) {
+    return !isCastling(mv) && (pos.mailbox[(mv >> 6) & 63] != NO_TYPE || isEnPassant(mv));
+}
+
+inline PieceTo pieceTo(const Position& pos, Move mv) {
+    return { isCastling(mv) ? KING : pos.mailbox[mv & 63], static_cast<Square>((mv >> 6) & 63) };
+}
+
+// History entries stay within [-HISTORY_MAX, HISTORY_MAX].
+constexpr int HISTORY_MAX{ 16384 };
+
+// Per-thread statistics of which quiet moves caused cutoffs.
+//  - butterfly: indexed by side, from and to square
+//  - continuation: indexed by side, the opponent's previous move and this
+//    move, so it learns which replies work against which moves
+//  - counter moves: the last quiet move that refuted a given previous move
+class History {
+public:
+    History() { clear(); }
+    void clear();
+    // Halves every entry, so that a new search still benefits from the last
+    // one but adapts quickly to the new position.
+    void age();
+
+    int quietScore(Colour us, Move mv, PieceTo moved, PieceTo prev) const;
+    // Adds bonus (negative for a malus) to the move's entries. Entries
+    // saturate smoothly towards HISTORY_MAX instead of overflowing.
+    void update(Colour us, Move mv, PieceTo moved, PieceTo prev, int bonus);
+
+    Move counterMove(Colour us, PieceTo prev) const;
+    void setCounterMove(Colour us, PieceTo prev, Move mv);
+
+private:
+    int16_t butterfly[NUM_COLOURS][NUM_SQUARES][NUM_SQUARES];
+    int16_t continuation[NUM_COLOURS][NUM_PIECE_TYPES][NUM_SQUARES][NUM_PIECE_TYPES][NUM_SQUARES];
+    Move counterMoves[NUM_COLOURS][NUM_PIECE_TYPES][NUM_SQUARES];
+};
+
+// History bonus for a quiet move that caused a cutoff at the given depth.
+inline int historyBonus(int depth) {
+    return std::min(depth * depth * 16, HISTORY_MAX / 8);
+}
+
+class MovePicker {
+public:
+    // Scores the moves in place. killers points at the ply's two killer
+    // moves; prev is the opponent's previous move (piece NO_TYPE at the root
+    // or after a null move).
+    MovePicker(const Position& pos, Movelist& moves, Move ttMove, const Move* killers,
+        PieceTo prev, const History& history);
+    // Returns the best remaining move, or 0 once all have been returned.
+    Move next();
+
+private:
+    Movelist& moves;
+    size_t current{ 0 };
+};
@@ -0,0 +1,256 @@
+#include "nnue.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include "bitops.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define NNUE_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC compiles intrinsics for any instruction set without extra flags;
+// GCC and Clang need each function marked with the set it may use.
+#if defined(NNUE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#else
+#define TARGET_AVX2
+#define TARGET_SSE41
+#endif
+
+Network NNUE;
+
+// At most two rows are added and two subtracted per move (a capture with
+// promotion, or castling).
+constexpr int MAX_DELTAS{ 2 };
+
+// === Kernels ===
+// updateRows: out = in + sum(adds) - sum(subs), over NNUE_HIDDEN int16s.
+// forward: sum of clamp(us, 0, QA) * w[0..H) + clamp(them, 0, QA) * w[H..2H).
+
+static void updateRowsScalar(int16_t* out, const int16_t* in,
+    const int16_t* const* adds, int addCount, const int16_t* const* subs, int subCount)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        int16_t v{ in[i] };
+        for (int a = 0; a < addCount; a++)
+            v += adds[a][i];
+        for (int s = 0; s < subCount; s++)
+            v -= subs[s][i];
+        out[i] = v;
+    }
+}
+
+static int32_t forwardScalar(const int16_t* us, const int16_t* them, const int16_t* w)
+{
+    int32_t sum{ 0 };
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        sum += std::clamp<int32_t>(us[i], 0, NNUE_QA) * w[i];
+        sum += std::clamp<int32_t>(them[i], 0, NNUE_QA) * w[NNUE_HIDDEN + i];
+    }
+    return sum;
+}
+
+#if defined(NNUE_X86)
+TARGET_SSE41 static void updateRowsSse41(int16_t* out, const int16_t* in,
+    const int16_t* const* adds, int addCount, const int16_t* const* subs, int subCount)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i v{ _mm_load_si128(reinterpret_cast<const __m128i*>(in + i)) };
+        for (int a = 0; a < addCount; a++)
+            v = _mm_add_epi16(v, _mm_load_si128(reinterpret_cast<const __m128i*>(adds[a] + i)));
+        for (int s = 0; s < subCount; s++)
+            v = _mm_sub_epi16(v, _mm_load_si128(reinterpret_cast<const __m128i*>(subs[s] + i)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(out + i), v);
+    }
+}
+
+TARGET_SSE41 static int32_t forwardSse41(const int16_t* us, const int16_t* them, const int16_t* w)
+{
+    const __m128i zero{ _mm_setzero_si128() };
+    const __m128i qa{ _mm_set1_epi16(NNUE_QA) };
+    __m128i sum{ _mm_setzero_si128() };
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i a{ _mm_load_si128(reinterpret_cast<const __m128i*>(us + i)) };
+        __m128i b{ _mm_load_si128(reinterpret_cast<const __m128i*>(them + i)) };
+        a = _mm_min_epi16(_mm_max_epi16(a, zero), qa);
+        b = _mm_min_epi16(_mm_max_epi16(b, zero), qa);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(a, _mm_load_si128(reinterpret_cast<const __m128i*>(w + i))));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(b, _mm_load_si128(reinterpret_cast<const __m128i*>(w + NNUE_HIDDEN + i))));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+TARGET_AVX2 static void updateRowsAvx2(int16_t* out, const int16_t* in,
+    const int16_t* const* adds, int addCount, const int16_t* const* subs, int subCount)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i v{ _mm256_load_si256(reinterpret_cast<const __m256i*>(in + i)) };
+        for (int a = 0; a < addCount; a++)
+            v = _mm256_add_epi16(v, _mm256_load_si256(reinterpret_cast<const __m256i*>(adds[a] + i)));
+        for (int s = 0; s < subCount; s++)
+            v = _mm256_sub_epi16(v, _mm256_load_si256(reinterpret_cast<const __m256i*>(subs[s] + i)));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(out + i), v);
+    }
+}
+
+TARGET_AVX2 static int32_t forwardAvx2(const int16_t* us, const int16_t* them, const int16_t* w)
+{
+    const __m256i zero{ _mm256_setzero_si256() };
+    const __m256i qa{ _mm256_set1_epi16(NNUE_QA) };
+    __m256i sum{ _mm256_setzero_si256() };
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i a{ _mm256_load_si256(reinterpret_cast<const __m256i*>(us + i)) };
+        __m256i b{ _mm256_load_si256(reinterpret_cast<const __m256i*>(them + i)) };
+        a = _mm256_min_epi16(_mm256_max_epi16(a, zero), qa);
+        b = _mm256_min_epi16(_mm256_max_epi16(b, zero), qa);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(a, _mm256_load_si256(reinterpret_cast<const __m256i*>(w + i))));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(b, _mm256_load_si256(reinterpret_cast<const __m256i*>(w + NNUE_HIDDEN + i))));
+    }
+    __m128i s{ _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1)) };
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+}
+#endif
+
+struct Kernels {
+    void (*updateRows)(int16_t*, const int16_t*, const int16_t* const*, int, const int16_t* const*, int);
+    int32_t (*forward)(const int16_t*, const int16_t*, const int16_t*);
+    const char* name;
+};
+
+static Kernels selectKernels()
+{
+#if defined(NNUE_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf{ info[0] };
+    __cpuid(info, 1);
+    const bool sse41{ (info[2] & (1 << 19)) != 0 };
+    const bool osAvx{ (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6 };
+    bool avx2{ false };
+    if (maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = osAvx && (info[1] & (1 << 5));
+    }
+#else
+    const bool avx2{ __builtin_cpu_supports("avx2") != 0 };
+    const bool sse41{ __builtin_cpu_supports("sse4.1") != 0 };
+#endif
+    if (avx2)
+        return { updateRowsAvx2, forwardAvx2, "AVX2" };
+    if (sse41)
+        return { updateRowsSse41, forwardSse41, "SSE4.1" };
+#endif
+    return { updateRowsScalar, forwardScalar, "scalar" };
+}
+
+static const Kernels kernels{ selectKernels() };
+
+// Input index of a piece as seen from one side's perspective: own pieces
+// first, and the board flipped for black so both sides see the same shape.
+static int featureIndex(Colour perspective, Colour co, PieceType pt, Square sq)
+{
+    const int relativeSq{ perspective == WHITE ? static_cast<int>(sq) : sq ^ 56 };
+    return (co == perspective ? 0 : 384) + pt * 64 + relativeSq;
+}
+
+const char* Network::kernelName() const
+{
+    return kernels.name;
+}
+
+void Network::load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("cannot open network file " + path);
+    // The parameters are the first bytes of the file; trainers may pad the
+    // end to a multiple of 64.
+    constexpr size_t PARAM_BYTES{ sizeof(int16_t)
+        * (NNUE_INPUTS * NNUE_HIDDEN + NNUE_HIDDEN + NUM_COLOURS * NNUE_HIDDEN + 1) };
+    std::unique_ptr<Weights> w{ new Weights };
+    file.read(reinterpret_cast<char*>(w->featureWeights), sizeof(w->featureWeights));
+    file.read(reinterpret_cast<char*>(w->featureBiases), sizeof(w->featureBiases));
+    file.read(reinterpret_cast<char*>(w->outputWeights), sizeof(w->outputWeights));
+    file.read(reinterpret_cast<char*>(&w->outputBias), sizeof(w->outputBias));
+    if (!file)
+        throw std::runtime_error("network file " + path + " is shorter than " + std::to_string(PARAM_BYTES) + " bytes");
+    file.seekg(0, std::ios::end);
+    if (static_cast<size_t>(file.tellg()) >= PARAM_BYTES + 64)
+        throw std::runtime_error("network file " + path + " is larger than expected; wrong architecture?");
+    weights = std::move(w);
+}
+
+void Network::refresh(Accumulator& acc, const Position& pos) const
+{
+    for (Colour perspective : { WHITE, BLACK }) {
+        int16_t* out{ acc.values[perspective] };
+        std::memcpy(out, weights->featureBiases, sizeof(weights->featureBiases));
+        for (int co = 0; co < NUM_COLOURS; co++) {
+            for (int pt = 0; pt < NUM_PIECE_TYPES; pt++) {
+                for (Bitboard bb = pos.bbByColour[co] & pos.bbByType[pt]; bb; bb &= bb - 1) {
+                    const int16_t* row{ weights->featureWeights[featureIndex(perspective,
+                        static_cast<Colour>(co), static_cast<PieceType>(pt), static_cast<Square>(lsb(bb)))] };
+                    kernels.updateRows(out, out, &row, 1, nullptr, 0);
+                }
+            }
+        }
+    }
+}
+
+void Network::update(Accumulator& acc, const Accumulator& prev, const Position& pos, Move mv) const
+{
+    // The same piece changes makeMove will apply, as (colour, type, square)
+    // triples to switch on and off.
+    struct Piece { Colour co; PieceType pt; Square sq; };
+    Piece added[MAX_DELTAS];
+    Piece removed[MAX_DELTAS];
+    int addCount{ 0 };
+    int removeCount{ 0 };
+    const Colour us{ pos.sideToMove };
+    const Square fromSq{ static_cast<Square>(mv & 63) };
+    const Square toSq{ static_cast<Square>((mv >> 6) & 63) };
+    if (isCastling(mv)) {
+        // Encoded as king square to rook square.
+        const bool west{ fromSq > toSq };
+        const int rank{ us == WHITE ? 0 : 56 };
+        removed[removeCount++] = { us, KING, fromSq };
+        removed[removeCount++] = { us, ROOK, toSq };
+        added[addCount++] = { us, KING, static_cast<Square>(rank + (west ? 2 : 6)) };
+        added[addCount++] = { us, ROOK, static_cast<Square>(rank + (west ? 3 : 5)) };
+    }
+    else {
+        const PieceType piece{ pos.mailbox[fromSq] };
+        removed[removeCount++] = { us, piece, fromSq };
+        added[addCount++] = { us, isPromotion(mv) ? getPromotionType(mv) : piece, toSq };
+        if (pos.mailbox[toSq] != NO_TYPE)
+            removed[removeCount++] = { !us, pos.mailbox[toSq], toSq };
+        else if (isEnPassant(mv))
+            removed[removeCount++] = { !us, PAWN, static_cast<Square>(us == WHITE ? toSq - 8 : toSq + 8) };
+    }
+    for (Colour perspective : { WHITE, BLACK }) {
+        const int16_t* adds[MAX_DELTAS];
+        const int16_t* subs[MAX_DELTAS];
+        for (int i = 0; i < addCount; i++)
+            adds[i] = weights->featureWeights[featureIndex(perspective, added[i].co, added[i].pt, added[i].sq)];
+        for (int i = 0; i < removeCount; i++)
+            subs[i] = weights->featureWeights[featureIndex(perspective, removed[i].co, removed[i].pt, removed[i].sq)];
+        kernels.updateRows(acc.values[perspective], prev.values[perspective], adds, addCount, subs, removeCount);
+    }
+}
+
+int Network::evaluate(const Accumulator& acc, Colour sideToMove) const
+{
+    const int32_t sum{ kernels.forward(acc.values[sideToMove], acc.values[!sideToMove], weights->outputWeights) };
+    return static_cast<int>((static_cast<int64_t>(sum) + weights->outputBias) * NNUE_SCALE / (NNUE_QA * NNUE_QB));
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "position.h"
+
+// === nnue.h ===
+// Efficiently updatable neural network evaluation.
+// Network: 768 inputs (colour, piece type, square) -> 2 x NNUE_HIDDEN
+// (one accumulator per side's perspective) -> clipped ReLU -> 1 output.
+// The first layer is the expensive one, but a move only switches a few inputs
+// on or off, so each ply's accumulator is derived from its parent's by adding
+// and subtracting a few weight rows instead of being recomputed. Inputs don't
+// depend on the king square, so king moves need no refresh.
+// The weights are int16 and are loaded with "setoption name EvalFile". The
+// file is the raw little-endian layout written by common trainers:
+//   feature weights [768][NNUE_HIDDEN], feature biases [NNUE_HIDDEN],
+//   output weights [2 * NNUE_HIDDEN], output bias [1]
+// The SIMD kernels (AVX2, SSE4.1 or scalar) are chosen at start-up from what
+// the CPU supports.
+
+constexpr int NNUE_INPUTS{ 768 };
+constexpr int NNUE_HIDDEN{ 256 };
+// Quantisation: activations are clipped to [0, NNUE_QA], output weights are
+// scaled by NNUE_QB, and the result is scaled to centipawns by NNUE_SCALE.
+constexpr int NNUE_QA{ 255 };
+constexpr int NNUE_QB{ 64 };
+constexpr int NNUE_SCALE{ 400 };
+
+struct alignas(64) Accumulator {
+    int16_t values[NUM_COLOURS][NNUE_HIDDEN];
+};
+
+class Network {
+public:
+    // Loads weights from a file. Throws std::runtime_error if the file can't
+    // be read or has the wrong size; the previous network stays in use.
+    void load(const std::string& path);
+    bool loaded() const { return weights != nullptr; }
+    // Name of the SIMD kernel set in use, for "info string".
+    const char* kernelName() const;
+
+    // Computes an accumulator from scratch.
+    void refresh(Accumulator& acc, const Position& pos) const;
+    // Derives the accumulator after mv from the one before it. pos must be
+    // the position before mv is made.
+    void update(Accumulator& acc, const Accumulator& prev, const Position& pos, Move mv) const;
+    // Evaluation in centipawns from the point of view of the side to move.
+    int evaluate(const Accumulator& acc, Colour sideToMove) const;
+
+private:
+    struct alignas(64) Weights {
+        int16_t featureWeights[NNUE_INPUTS][NNUE_HIDDEN];
+        int16_t featureBiases[NNUE_HIDDEN];
+        int16_t outputWeights[NUM_COLOURS * NNUE_HIDDEN];
+        int16_t outputBias;
+    };
+    std::unique_ptr<Weights> weights;
+};
+
+extern Network NNUE;
@@ -0,0 +1,45 @@
+#include "pawns.h"
+#include "evaluation.h"
+
+static void evaluatePawns(const Position& pos, Colour co, PawnEntry& e, int& mg, int& eg)
+{
+    const Bitboard ownPawns{ pos.bbByType[PAWN] & pos.bbByColour[co] };
+    const Bitboard enemyPawns{ pos.bbByType[PAWN] & pos.bbByColour[!co] };
+    for (Bitboard bb = ownPawns; bb; bb &= bb - 1) {
+        const int sq{ lsb(bb) };
+        e.attacks[co] |= pawnAttacks[co][sq];
+        e.attackSpans[co] |= passedPawnMasks[co][sq] & ~forwardFiles[co][sq];
+        // A pawn with an own pawn in front of it is doubled and can't be passed.
+        const bool doubled{ (forwardFiles[co][sq] & ownPawns) != 0 };
+        if (doubled) {
+            mg += DOUBLED_PAWN_MG;
+            eg += DOUBLED_PAWN_EG;
+        }
+        if (!(adjacentFiles[sq & 7] & ownPawns)) {
+            mg += ISOLATED_PAWN_MG;
+            eg += ISOLATED_PAWN_EG;
+        }
+        if (!doubled && !(passedPawnMasks[co][sq] & enemyPawns)) {
+            const int rank{ co == WHITE ? sq >> 3 : 7 - (sq >> 3) };
+            e.passed[co] |= 1ULL << sq;
+            mg += PASSED_PAWN_MG[rank];
+            eg += PASSED_PAWN_EG[rank];
+        }
+    }
+}
+
+const PawnEntry& PawnTable::probe(const Position& pos)
+{
+    PawnEntry& e{ table[pos.pawnKey & (PAWN_TABLE_SIZE - 1)] };
+    if (e.key == pos.pawnKey)
+        return e;
+    e = PawnEntry{};
+    e.key = pos.pawnKey;
+    int mgBlack{ 0 };
+    int egBlack{ 0 };
+    evaluatePawns(pos, WHITE, e, e.mg, e.eg);
+    evaluatePawns(pos, BLACK, e, mgBlack, egBlack);
+    e.mg -= mgBlack;
+    e.eg -= egBlack;
+    return e;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include "position.h"
+
+// === pawns.h ===
+// Pawn structure evaluation and its cache. Pawn structure changes far less
+// often than the rest of the position, so everything derived from the pawns
+// alone is computed once per pawn key (see Position::pawnKey) and kept in a
+// small table. Each search thread has its own table, so there's no locking.
+
+// Number of entries; a power of two.
+constexpr size_t PAWN_TABLE_SIZE{ 16384 };
+
+struct PawnEntry {
+    uint64_t key{ 0 };
+    // Pawn structure score from white's point of view.
+    int mg{ 0 };
+    int eg{ 0 };
+    Bitboard passed[NUM_COLOURS]{};
+    // Squares attacked by the pawns now, and every square they could attack
+    // as they advance (so ~attackSpans are squares safe from them for good).
+    Bitboard attacks[NUM_COLOURS]{};
+    Bitboard attackSpans[NUM_COLOURS]{};
+};
+
+class PawnTable {
+public:
+    PawnTable() : table(new PawnEntry[PAWN_TABLE_SIZE]) {}
+    // Returns the entry for the position's pawns, computing it on a miss.
+    const PawnEntry& probe(const Position& pos);
+
+private:
+    std::unique_ptr<PawnEntry[]> table;
+};
@@ -0,0 +1,148 @@
+#include "perft.h"
+#include <chrono>
+#include <vector>
+
+void PerftTable::resize(size_t megabytes)
+{
+    size_t count{ 1 };
+    while (count * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024)
+        count *= 2;
+    table.reset();
+    table.reset(new Bucket[count]);
+    bucketCount = count;
+}
+
+void PerftTable::clear()
+{
+    for (size_t i = 0; i < bucketCount; i++)
+    {
+        for (Entry& e : table[i].entries)
+        {
+            e.keyXorData.store(0, std::memory_order_relaxed);
+            e.data.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool PerftTable::probe(uint64_t key, int depth, uint64_t& nodes) const
+{
+    const Bucket& bucket{ bucketFor(key) };
+    for (const Entry& e : bucket.entries)
+    {
+        const uint64_t data{ e.data.load(std::memory_order_relaxed) };
+        if ((e.keyXorData.load(std::memory_order_relaxed) ^ data) == key
+            && static_cast<int>(data & 0xFF) == depth)
+        {
+            nodes = data >> 8;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerftTable::store(uint64_t key, int depth, uint64_t nodes)
+{
+    Bucket& bucket{ bucketFor(key) };
+    const uint64_t data{ (nodes << 8) | static_cast<uint64_t>(depth) };
+    Entry& deep{ bucket.entries[0] };
+    Entry& e{ depth >= static_cast<int>(deep.data.load(std::memory_order_relaxed) & 0xFF) ? deep : bucket.entries[1] };
+    e.keyXorData.store(key ^ data, std::memory_order_relaxed);
+    e.data.store(data, std::memory_order_relaxed);
+}
+
+uint64_t perft(int depth, Position& pos)
+{
+    // Recursive function to count all legal moves (nodes) at depth n.
+    uint64_t nodes = 0;
+    // Terminating condition
+    if (depth == 0) { return 1; }
+    //std::cout << pos.pretty_cb();
+    Movelist mvlist = generateLegalMoves(pos);
+    int sz = mvlist.size();
+    // Recurse.
+    for (int i = 0; i < sz; ++i) {
+        pos.makeMove(mvlist[i]);
+        nodes += perft(depth - 1, pos);
+        pos.unmakeMove(mvlist[i]);
+    }
+    return nodes;
+}
+
+uint64_t perftHashed(int depth, Position& pos, PerftTable& table)
+{
+    Movelist mvlist = generateLegalMoves(pos);
+    // Bulk counting: the moves at depth 1 are the leaves.
+    if (depth <= 1)
+        return depth == 1 ? mvlist.size() : 1;
+    uint64_t nodes = 0;
+    if (table.probe(pos.key, depth, nodes))
+        return nodes;
+    for (Move mv : mvlist) {
+        pos.makeMove(mv);
+        nodes += perftHashed(depth - 1, pos, table);
+        pos.unmakeMove(mv);
+    }
+    table.store(pos.key, depth, nodes);
+    return nodes;
+}
+
+static void splitPerft(int depth, int split, Position& pos, PerftTable& table, ThreadPool& pool,
+    std::atomic<uint64_t>& counter)
+{
+    // Walks the first plies on the calling thread and hands every subtree
+    // below them to the pool as a task with its own copy of the position.
+    uint64_t nodes = 0;
+    if (split <= 0 || depth <= 2) {
+        auto copy{ std::make_shared<Position>(pos) };
+        pool.submit([depth, copy, &table, &counter] {
+            counter.fetch_add(perftHashed(depth, *copy, table), std::memory_order_relaxed);
+            });
+        return;
+    }
+    if (table.probe(pos.key, depth, nodes)) {
+        counter.fetch_add(nodes, std::memory_order_relaxed);
+        return;
+    }
+    Movelist mvlist = generateLegalMoves(pos);
+    for (Move mv : mvlist) {
+        pos.makeMove(mv);
+        splitPerft(depth - 1, split - 1, pos, table, pool, counter);
+        pos.unmakeMove(mv);
+    }
+}
+
+uint64_t perftParallel(int depth, Position& pos, PerftTable& table, ThreadPool& pool, int splitDepth)
+{
+    std::atomic<uint64_t> nodes{ 0 };
+    splitPerft(depth, splitDepth, pos, table, pool, nodes);
+    pool.wait();
+    return nodes;
+}
+
+uint64_t perftDivide(int depth, Position& pos, PerftTable& table, ThreadPool& pool, std::ostream& out)
+{
+    const auto start{ std::chrono::steady_clock::now() };
+    Movelist mvlist = generateLegalMoves(pos);
+    std::vector<std::atomic<uint64_t>> counts(mvlist.size());
+    if (depth == 1) {
+        for (auto& c : counts)
+            c = 1;
+    }
+    else {
+        for (size_t i = 0; i < mvlist.size(); i++) {
+            pos.makeMove(mvlist[i]);
+            splitPerft(depth - 1, PERFT_SPLIT_DEPTH - 1, pos, table, pool, counts[i]);
+            pos.unmakeMove(mvlist[i]);
+        }
+        pool.wait();
+    }
+    uint64_t total = 0;
+    for (size_t i = 0; i < mvlist.size(); i++) {
+        out << toStringUCI(mvlist[i]) << ": " << counts[i] << "\n";
+        total += counts[i];
+    }
+    const long long ms{ std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count() };
+    out << "\nnodes " << total << " time " << ms << " nps " << total * 1000 / (ms + 1) << std::endl;
+    return total;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include "position.h"
+#include "movegen.h"
+#include "threadpool.h"
+
+// === perft.h ===
+// Move generation test: counts the leaf nodes of the legal move tree.
+// The fast variant counts the moves at depth 1 instead of making them (bulk
+// counting) and caches subtree counts by (Zobrist key, depth) in a table of
+// its own, so transpositions are counted once. Entries use the same
+// key ^ data check as the transposition table, so the table can be shared by
+// several threads without locks.
+
+constexpr int DEFAULT_PERFT_HASH_MB{ 16 };
+// Plies below the root at which parallel perft hands subtrees to the thread
+// pool. A deeper split gives more, smaller tasks and better load balance, but
+// every task copies a Position.
+constexpr int PERFT_SPLIT_DEPTH{ 3 };
+
+class PerftTable {
+public:
+    PerftTable() { resize(DEFAULT_PERFT_HASH_MB); }
+    // Reallocates the table to the largest power-of-two size in megabytes
+    // that fits. Clears its contents.
+    void resize(size_t megabytes);
+    void clear();
+    bool probe(uint64_t key, int depth, uint64_t& nodes) const;
+    void store(uint64_t key, int depth, uint64_t nodes);
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> keyXorData{ 0 };
+        std::atomic<uint64_t> data{ 0 };    // nodes (56) | depth (8)
+    };
+    // The first entry of a bucket keeps the deeper subtree, the second is
+    // always replaced.
+    struct alignas(32) Bucket {
+        Entry entries[2];
+    };
+
+    Bucket& bucketFor(uint64_t key) const { return table[key & (bucketCount - 1)]; }
+
+    std::unique_ptr<Bucket[]> table;
+    size_t bucketCount{ 0 };
+};
+
+// Plain recursive perft without bulk counting or hashing; kept as a reference.
+uint64_t perft(int depth, Position& pos);
+// Bulk-counting perft backed by a perft table.
+uint64_t perftHashed(int depth, Position& pos, PerftTable& table);
+// perftHashed with the subtrees splitDepth plies below the root run as tasks
+// on the pool. The table is shared by all tasks.
+uint64_t perftParallel(int depth, Position& pos, PerftTable& table, ThreadPool& pool,
+    int splitDepth = PERFT_SPLIT_DEPTH);
+// Prints the node count below every root move ("divide"), then the total
+// node count, the time taken and the speed. Returns the total.
+uint64_t perftDivide(int depth, Position& pos, PerftTable& table, ThreadPool& pool, std::ostream& out);
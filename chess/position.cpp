@@ -1,7 +1,10 @@
 #include "position.h"
 #include "movegen.h"
 #include "bitboard_lookup.h"
-#include <chrono>
+#include "bitops.h"
+#include <algorithm>
+
+const ZobristKeys zobrist{};
 
 uint64_t murmur64(uint64_t h) {
     h ^= h >> 33;
@@ -105,7 +108,8 @@ void Position::setFromFen(const std::string& fenStr) {
     // Converting a fullmove number to halfmove number.
     // Halfmove 0 = Fullmove 1 + white to move.
     halfmoveNum = 2 * fullmoveNum - 1 - (sideToMove == WHITE);
-    hashes.push_back(calculateHash());
+    key = calculateHash();
+    keyHistory[0] = key;
     return;
 }
 
@@ -114,39 +118,34 @@ void Position::addPiece(PieceType piece,Colour colour, Square sq) {
     bbByColour[colour] |= bb;
     bbByType[piece] |= bb;
     occupancy |= bb;
+    mailbox[sq] = piece;
+    key ^= zobrist.pieceSquare[colour][piece][sq];
+    if (piece == PAWN)
+        pawnKey ^= zobrist.pieceSquare[colour][PAWN][sq];
+    psqtAdd(colour, piece, sq);
     return;
 }
 
 void Position::removePiece(Square sq) {
-    Bitboard bb = ~(1ULL << sq);
-    bbByColour[WHITE] &= bb;
-    bbByColour[BLACK] &= bb;
-    occupancy &= bb;
-    for (int i = 0; i < 6; i++)
-    {
-        bbByType[i] &= bb;
-    }
+    const PieceType piece{ mailbox[sq] };
+    if (piece != NO_TYPE)
+        removePiece(sq, piece);
     return;
 }
 
 void Position::removePiece(Square sq, PieceType i)
 {
+    const Colour co{ static_cast<Colour>((bbByColour[WHITE] >> sq) & 1) };
+    key ^= zobrist.pieceSquare[co][i][sq];
+    if (i == PAWN)
+        pawnKey ^= zobrist.pieceSquare[co][PAWN][sq];
+    psqtRemove(co, i, sq);
     Bitboard bb = ~(1ULL << sq);
     bbByColour[WHITE] &= bb;
     bbByColour[BLACK] &= bb;
     occupancy &= bb;
     bbByType[i] &= bb;
-}
-
-PieceType Position::figurePieceFromSq(Square sq)
-{
-    Bitboard bb = (1ULL << sq);
-    for (int i = 0; i < 6; i++)
-    {
-        if ((bb & bbByType[i]) > 0)
-            return static_cast<PieceType>(i);
-    }
-    return PieceType{ NO_TYPE };
+    mailbox[sq] = NO_TYPE;
 }
 
 void Position::makeCastlingMove(Move mv) {
@@ -186,19 +185,31 @@ void Position::makeCastlingMove(Move mv) {
     occupancy ^= ((1ULL << sqKFrom) | (1ULL << sqRFrom) | (1ULL << sqKTo) | (1ULL << sqRTo));
     bbByType[KING] ^= ((1ULL << sqKFrom) | (1ULL << sqKTo));
     bbByType[ROOK] ^= ((1ULL << sqRFrom) | (1ULL << sqRTo));
+    mailbox[sqKFrom] = NO_TYPE;
+    mailbox[sqRFrom] = NO_TYPE;
+    mailbox[sqKTo] = KING;
+    mailbox[sqRTo] = ROOK;
+    psqtMove(co, KING, sqKFrom, sqKTo);
+    psqtMove(co, ROOK, sqRFrom, sqRTo);
 
     // Save irreversible information in struct, *before* altering them.
-    const StateInfo undoState{ NO_TYPE, castlingRights,
-                               enPassantRights, fiftyMoveNum,hashes };
-    undoStack.push_back(undoState);
+    undoStack[gamePly & (HISTORY_SIZE - 1)] = StateInfo{ NO_TYPE, castlingRights,
+                                                         enPassantRights, fiftyMoveNum };
+    key ^= zobrist.pieceSquare[co][KING][sqKFrom] ^ zobrist.pieceSquare[co][KING][sqKTo]
+         ^ zobrist.pieceSquare[co][ROOK][sqRFrom] ^ zobrist.pieceSquare[co][ROOK][sqRTo];
     // Update ep and castling rights.
+    if (enPassantRights != NO_SQ)
+        key ^= zobrist.enPassantFile[enPassantRights & 7];
     enPassantRights = NO_SQ;
+    key ^= zobrist.castling[castlingRights];
     castlingRights &= (co == WHITE) ? ~(CASTLE_WLONG | CASTLE_WSHORT) : ~(CASTLE_BLONG | CASTLE_BSHORT);
+    key ^= zobrist.castling[castlingRights];
     // Change side to move, and update fifty-move and halfmove counts.
     sideToMove = !sideToMove;
+    key ^= zobrist.blackToMove;
     ++fiftyMoveNum;
-    hashes.clear();
     ++halfmoveNum;
+    keyHistory[++gamePly & (HISTORY_SIZE - 1)] = key;
     return;
 }
 
@@ -216,7 +227,7 @@ void Position::makeMove(Move mv)
 
     const Square fromSq{ static_cast<Square>(mv&63) };
     const Square toSq{ static_cast<Square>((mv>>6) & 63) };
-    const PieceType piece= figurePieceFromSq(fromSq);
+    const PieceType piece{ mailbox[fromSq] };
     if (piece == NO_TYPE)
         throw std::runtime_error("Trying to make move with no piece selected");
     const Colour co{ sideToMove };
@@ -227,7 +238,7 @@ void Position::makeMove(Move mv)
     occupancy ^= (1ULL << fromSq);
 
     // Handle regular captures and en passant separately
-    const PieceType pcDest=figurePieceFromSq(toSq);
+    const PieceType pcDest{ mailbox[toSq] };
     const bool isCapture { pcDest != NO_TYPE };
     if (isCapture) 
     {
@@ -235,6 +246,9 @@ void Position::makeMove(Move mv)
         bbByColour[!co] ^= (1ULL << toSq);
         bbByType[pcDest] ^= (1ULL << toSq);
         occupancy ^= (1ULL << toSq);
+        psqtRemove(!co, pcDest, toSq);
+        if (pcDest == PAWN)
+            pawnKey ^= zobrist.pieceSquare[!co][PAWN][toSq];
     } else if (isEnPassant(mv)) 
     {
         // ep capture is occurring, erase the captured pawn
@@ -249,101 +263,89 @@ void Position::makeMove(Move mv)
         bbByColour[co] ^= (1ULL<<toSq);
         bbByType[pctyPromo] ^= (1ULL<<toSq);
         occupancy ^= (1ULL << toSq);
+        mailbox[toSq] = pctyPromo;
+        psqtRemove(co, PAWN, fromSq);
+        psqtAdd(co, pctyPromo, toSq);
+        pawnKey ^= zobrist.pieceSquare[co][PAWN][fromSq];
     }
     else {
         bbByColour[co] ^= (1ULL << toSq);
         bbByType[piece] ^= (1ULL << toSq);
         occupancy ^= (1ULL << toSq);
+        mailbox[toSq] = piece;
+        psqtMove(co, piece, fromSq, toSq);
+        if (piece == PAWN)
+            pawnKey ^= zobrist.pieceSquare[co][PAWN][fromSq] ^ zobrist.pieceSquare[co][PAWN][toSq];
     }
+    mailbox[fromSq] = NO_TYPE;
     // Save irreversible state information in struct, *before* altering them.
-    undoStack.push_back(StateInfo{ pcDest, castlingRights, enPassantRights, fiftyMoveNum,hashes });
+    undoStack[gamePly & (HISTORY_SIZE - 1)] = StateInfo{ pcDest, castlingRights, enPassantRights, fiftyMoveNum };
+    key ^= zobrist.pieceSquare[co][piece][fromSq]
+         ^ zobrist.pieceSquare[co][isPromotion(mv) ? getPromotionType(mv) : piece][toSq];
+    if (isCapture)
+        key ^= zobrist.pieceSquare[!co][pcDest][toSq];
+    if (enPassantRights != NO_SQ)
+        key ^= zobrist.enPassantFile[enPassantRights & 7];
 
     // Update ep rights.
     if (piece == PAWN && ((fromSq-toSq==16) || (fromSq - toSq == -16))) {
         enPassantRights = static_cast<Square>((fromSq + toSq) / 2); // average gives middle square
+        key ^= zobrist.enPassantFile[enPassantRights & 7];
     }
     else {
         enPassantRights = NO_SQ;
     }
     // Update castling rights.
-    // Castling rights are lost if the king moves.
+    // Castling rights are lost if the king moves, or a rook moves or is
+    // captured. A rook move can be a capture of the other rook, so each
+    // corner is tested on its own.
+    key ^= zobrist.castling[castlingRights];
     if (piece == KING)
     {
         castlingRights &= (co == WHITE) ? ~(CASTLE_WLONG | CASTLE_WSHORT) : ~(CASTLE_BLONG | CASTLE_BSHORT);
     }
-    else if (fromSq==A1 || toSq == A1) {
+    if (fromSq==A1 || toSq == A1) {
         castlingRights &= ~CASTLE_WLONG;
     }
-    else if (fromSq == H1 || toSq == H1) {
+    if (fromSq == H1 || toSq == H1) {
         castlingRights &= ~CASTLE_WSHORT;
     }
-    else if (fromSq == A8 || toSq == A8) {
+    if (fromSq == A8 || toSq == A8) {
         castlingRights &= ~CASTLE_BLONG;
     }
-    else if (fromSq == H8 || toSq == H8) {
+    if (fromSq == H8 || toSq == H8) {
         castlingRights &= ~CASTLE_BSHORT;
     }
+    key ^= zobrist.castling[castlingRights];
     // Change side to move, and update fifty-move and halfmove counts.
     sideToMove = !sideToMove;
+    key ^= zobrist.blackToMove;
     if (isCapture || (piece == PAWN)) {
         fiftyMoveNum = 0;
-        hashes.clear();
     }
     else {
-        hashes.push_back(calculateHash());
-        bool second_repetition = false;
-        for (int j = hashes.size() - 2; j >= 0; j--)
-        {
-            if (hashes[j] == hashes.back())
-            {
-                if (second_repetition)
-                    gameover = true;
-                else second_repetition = true;
-            }
-        }
         ++fiftyMoveNum;
     }
+    keyHistory[++gamePly & (HISTORY_SIZE - 1)] = key;
     ++halfmoveNum;
     return;
 }
 
 void Position::makeMoveFronStr_UCI(std::string usi_str)
 {
-    if (usi_str.size() < 4)
-        return;
-    if (usi_str == "e8g8")
+    // Match against the legal moves, so castling, en passant and promotions
+    // get their proper encoding and an illegal move is ignored. A promotion
+    // sent without its piece letter is taken as a queen promotion.
+    for (Move mv : generateLegalMoves(*this))
     {
-        makeCastlingMove(buildCastling(E8, H8));
-        return;
-    } else if (usi_str == "e8c8")
-    {
-        makeCastlingMove(buildCastling(E8, A8));
-        return;
-    }
-    else if (usi_str == "e1c1")
-    {
-        makeCastlingMove(buildCastling(E1, A1));
-        return;
-    }
-    else if (usi_str == "e1g1")
-    {
-        makeCastlingMove(buildCastling(E1, H1));
-        return;
+        const std::string str{ toStringUCI(mv) };
+        if (str == usi_str
+            || (isPromotion(mv) && getPromotionType(mv) == QUEEN && str == usi_str + "q"))
+        {
+            makeMove(mv);
+            return;
+        }
     }
-    
-    int file_from = usi_str[0] - 'a';
-    int rank_from = usi_str[1] - '1';
-    int file_to = usi_str[2] - 'a';
-    int rank_to = usi_str[3] - '1';
-    if (file_from < 0 || file_from>7
-        || file_to < 0 || file_to>7
-        || rank_from < 0 || rank_from>7
-        || rank_to < 0 || rank_to>7)
-        return;
-    if (static_cast<Square>(rank_to * 8 + file_to) == enPassantRights && figurePieceFromSq(static_cast<Square>(rank_from * 8 + file_from)) == PAWN)
-        makeMove(buildEnPassant(static_cast<Square>(rank_from * 8 + file_from), static_cast<Square>(rank_to * 8 + file_to)));
-    else
-        makeMove(buildMove(static_cast<Square>(rank_from * 8 + file_from), static_cast<Square>(rank_to * 8 + file_to)));
 }
 
 void Position::unmakeCastlingMove(Move mv) {
@@ -375,15 +377,15 @@ void Position::unmakeCastlingMove(Move mv) {
         }
     }
     // Grab undo information off the stack. Assumes it matches the move called.
-    StateInfo undoState{ undoStack.back() };
-    undoStack.pop_back();
+    --gamePly;
+    const StateInfo& undoState{ undoStack[gamePly & (HISTORY_SIZE - 1)] };
+    key = keyHistory[gamePly & (HISTORY_SIZE - 1)];
 
     // Revert side to move, castling and ep rights, fifty- and half-move counts.
     sideToMove = !sideToMove;
     castlingRights = undoState.castlingRights;
     enPassantRights = undoState.enPassantRights;
     fiftyMoveNum = undoState.fiftyMoveNum;
-    hashes = undoState.hashes;
     halfmoveNum--;
 
     // Put king and rook back on their original squares.
@@ -391,6 +393,12 @@ void Position::unmakeCastlingMove(Move mv) {
     occupancy ^= ((1ULL << sqKFrom) | (1ULL << sqRFrom) | (1ULL << sqKTo) | (1ULL << sqRTo));
     bbByType[KING] ^= ((1ULL << sqKFrom) | (1ULL << sqKTo));
     bbByType[ROOK] ^= ((1ULL << sqRFrom) | (1ULL << sqRTo));
+    mailbox[sqKTo] = NO_TYPE;
+    mailbox[sqRTo] = NO_TYPE;
+    mailbox[sqKFrom] = KING;
+    mailbox[sqRFrom] = ROOK;
+    psqtMove(co, KING, sqKTo, sqKFrom);
+    psqtMove(co, ROOK, sqRTo, sqRFrom);
     return;
 }
 
@@ -403,21 +411,21 @@ void Position::unmakeMove(Move mv)
     }
     const Square fromSq{ static_cast<Square>(mv & 63) };
     const Square toSq{ static_cast<Square>((mv >> 6) & 63) };
-    const PieceType piece = figurePieceFromSq(toSq);
+    const PieceType piece{ mailbox[toSq] };
     if (piece == NO_TYPE)
         throw std::runtime_error("Trying to unmake move with no piece selected");
     const Colour co{ !sideToMove };
 
     // Grab undo information off the stack. Assumes it matches the move called.
-    StateInfo undoState{ undoStack.back() };
-    undoStack.pop_back();
+    --gamePly;
+    const StateInfo& undoState{ undoStack[gamePly & (HISTORY_SIZE - 1)] };
+    key = keyHistory[gamePly & (HISTORY_SIZE - 1)];
 
     // Revert side to move, castling and ep rights, fifty- and half-move counts.
     sideToMove = !sideToMove;
     castlingRights = undoState.castlingRights;
     enPassantRights = undoState.enPassantRights;
     fiftyMoveNum = undoState.fiftyMoveNum;
-    hashes = undoState.hashes;
     --halfmoveNum;
 
     // Put unit back on original square.
@@ -426,16 +434,29 @@ void Position::unmakeMove(Move mv)
     bbByType[piece] ^= (1ULL << toSq);
     if (isPromotion(mv)) {
         bbByType[PAWN] ^= (1ULL << fromSq);
+        mailbox[fromSq] = PAWN;
+        psqtRemove(co, piece, toSq);
+        psqtAdd(co, PAWN, fromSq);
+        pawnKey ^= zobrist.pieceSquare[co][PAWN][fromSq];
     }
     else {
         bbByType[piece] ^= (1ULL << fromSq);
+        mailbox[fromSq] = piece;
+        psqtMove(co, piece, toSq, fromSq);
+        if (piece == PAWN)
+            pawnKey ^= zobrist.pieceSquare[co][PAWN][fromSq] ^ zobrist.pieceSquare[co][PAWN][toSq];
     }
+    mailbox[toSq] = NO_TYPE;
     // Put back captured piece, if any (en passant handled separately.)
     const PieceType pcCap = undoState.capturedPiece;
     if (pcCap != NO_TYPE) {
         bbByColour[!co] ^= (1ULL<<toSq);
         bbByType[pcCap] ^= (1ULL << toSq);
         occupancy ^= (1ULL << toSq);
+        mailbox[toSq] = pcCap;
+        psqtAdd(!co, pcCap, toSq);
+        if (pcCap == PAWN)
+            pawnKey ^= zobrist.pieceSquare[!co][PAWN][toSq];
 
     }
 
@@ -445,8 +466,10 @@ void Position::unmakeMove(Move mv)
         bbByColour[!co] ^= (1ULL << sqEpCap);
         bbByType[PAWN] ^= (1ULL << sqEpCap);
         occupancy ^= (1ULL << sqEpCap);
+        mailbox[sqEpCap] = PAWN;
+        psqtAdd(!co, PAWN, sqEpCap);
+        pawnKey ^= zobrist.pieceSquare[!co][PAWN][sqEpCap];
     }
-    gameover = false;
     return;
 }
 
@@ -455,22 +478,71 @@ void Position::setStartingPosition()
     setFromFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
 }
 
-uint64_t Position::calculateHash()
+uint64_t Position::calculateHash() const
 {
-    uint64_t hash = bbByType[PAWN] | static_cast<uint64_t>(castlingRights) | (static_cast<uint64_t>(enPassantRights) << 56);
-    for (int i = NUM_PIECE_TYPES-1; i >= 0; i--)
+    uint64_t hash{ zobrist.castling[castlingRights] };
+    for (int co = 0; co < NUM_COLOURS; co++)
     {
-        if (i == PAWN)
-            continue;
-        hash ^= murmur64(bbByType[i]);
+        for (int pt = 0; pt < NUM_PIECE_TYPES; pt++)
+        {
+            Bitboard bb{ bbByColour[co] & bbByType[pt] };
+            while (bb)
+            {
+                hash ^= zobrist.pieceSquare[co][pt][lsb(bb)];
+                bb &= bb - 1;
+            }
+        }
     }
+    if (enPassantRights != NO_SQ)
+        hash ^= zobrist.enPassantFile[enPassantRights & 7];
+    if (sideToMove == BLACK)
+        hash ^= zobrist.blackToMove;
     return hash;
 }
 
+void Position::makeNullMove()
+{
+    undoStack[gamePly & (HISTORY_SIZE - 1)] = StateInfo{ NO_TYPE, castlingRights, enPassantRights, fiftyMoveNum };
+    if (enPassantRights != NO_SQ)
+        key ^= zobrist.enPassantFile[enPassantRights & 7];
+    enPassantRights = NO_SQ;
+    sideToMove = !sideToMove;
+    key ^= zobrist.blackToMove;
+    fiftyMoveNum = 0;
+    ++halfmoveNum;
+    keyHistory[++gamePly & (HISTORY_SIZE - 1)] = key;
+}
+
+void Position::unmakeNullMove()
+{
+    --gamePly;
+    const StateInfo& undoState{ undoStack[gamePly & (HISTORY_SIZE - 1)] };
+    key = keyHistory[gamePly & (HISTORY_SIZE - 1)];
+    sideToMove = !sideToMove;
+    enPassantRights = undoState.enPassantRights;
+    fiftyMoveNum = undoState.fiftyMoveNum;
+    --halfmoveNum;
+}
+
+int Position::repetitionCount() const
+{
+    // Only positions with the same side to move can repeat, and none from
+    // before the last capture or pawn move.
+    const int limit{ std::min(fiftyMoveNum, gamePly) };
+    int count{ 0 };
+    for (int i = 4; i <= limit; i += 2)
+    {
+        if (keyHistory[(gamePly - i) & (HISTORY_SIZE - 1)] == key)
+            count++;
+    }
+    return count;
+}
+
 void Position::reset()
 {
     bbByColour={};
     bbByType={};
+    mailbox.fill(NO_TYPE);
     // Game state information
     occupancy = 0;
     sideToMove={ WHITE };
@@ -478,7 +550,12 @@ void Position::reset()
     enPassantRights={ NO_SQ };
     fiftyMoveNum={ 0 };
     halfmoveNum={ 0 };
-    hashes.clear();
+    key = 0;
+    pawnKey = 0;
+    psqtMg = 0;
+    psqtEg = 0;
+    phase = 0;
+    gamePly = 0;
 }
 
 std::string Position::pretty_cb() const {
@@ -543,29 +620,3 @@ std::string Position::pretty_cb() const {
     strOut += "halfmoveNum: " + std::to_string(halfmoveNum) + "\n";
     return strOut;
 }
-
-//int main()
-//{
-//    Position cg;
-//    cg.setFromFen("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
-//    //cg.setStartingPosition();
-//    initialiseFirstRankAttacks();
-//    initialiseAllDiagMasks();
-//    initialiseFirstFileAttacks();
-//    initialiseKnightAttacks();
-//    initialiseKingAttacks();
-//    initialisePawnAttacks();
-//    auto start = std::chrono::high_resolution_clock::now();
-//    std::cout<< perft_parallel(6,cg);
-//    auto end = std::chrono::high_resolution_clock::now();
-//    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-//
-//    std::cout << "Execution time: " << duration.count() << " ms\n";
-//    start = std::chrono::high_resolution_clock::now();
-//    std::cout << perft(6, cg);
-//    end = std::chrono::high_resolution_clock::now();
-//    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-//
-//    std::cout << "Execution time: " << duration.count() << " ms\n";
-//    
-//}
\ No newline at end of file
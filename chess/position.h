@@ -2,51 +2,94 @@
 #include <cstdint>
 #include <array>
 #include <sstream>
+#include <vector>
 #include "bitboard.h"
 #include "bitboard_lookup.h"
 #include "move.h"
+#include "psqt.h"
+// === Zobrist keys ===
+// Random numbers XORed together to give a position key that is updated
+// incrementally as moves are made. Generated at compile time from a fixed
+// seed, so keys are identical across runs.
+struct ZobristKeys {
+    uint64_t pieceSquare[NUM_COLOURS][NUM_PIECE_TYPES][NUM_SQUARES]{};
+    uint64_t castling[16]{};        // indexed by the castlingRights bitmask
+    uint64_t enPassantFile[8]{};
+    uint64_t blackToMove{ 0 };
+
+    constexpr ZobristKeys() {
+        uint64_t seed{ 0x9E3779B97F4A7C15ULL };
+        for (int co = 0; co < NUM_COLOURS; co++)
+            for (int pt = 0; pt < NUM_PIECE_TYPES; pt++)
+                for (int sq = 0; sq < NUM_SQUARES; sq++)
+                    pieceSquare[co][pt][sq] = next(seed);
+        for (int cr = 0; cr < 16; cr++)
+            castling[cr] = next(seed);
+        for (int f = 0; f < 8; f++)
+            enPassantFile[f] = next(seed);
+        blackToMove = next(seed);
+    }
+
+private:
+    // xorshift64* pseudo-random generator.
+    static constexpr uint64_t next(uint64_t& s) {
+        s ^= s >> 12;
+        s ^= s << 25;
+        s ^= s >> 27;
+        return s * 0x2545F4914F6CDD1DULL;
+    }
+};
+
+extern const ZobristKeys zobrist;
+
 // === StateInfo ===
 // A struct for irreversible info about the position, for unmaking moves.
+// The Zobrist key is not stored here but in Position::keyHistory.
 struct StateInfo {
-    StateInfo() = default;
     PieceType capturedPiece{ NO_TYPE };
     int castlingRights{ NO_CASTLE };
     Square enPassantRights{ NO_SQ };
     int fiftyMoveNum{ 0 };
-    std::vector<uint64_t> hashes;
 };
 
+// Number of plies of undo information and keys kept by Position. Both are
+// ring buffers indexed by gamePly, so only the most recent HISTORY_SIZE moves
+// can be unmade or checked for repetition. The fifty-move rule and the
+// search depth keep the real requirement far below this.
+constexpr int HISTORY_SIZE{ 1024 };
+
 class Position
 {
 public:
-    Position() = default;
-    Position(const Position& pos) :
-        bbByColour(pos.bbByColour),
-        bbByType(pos.bbByType),
-        occupancy(pos.occupancy),
-        sideToMove(pos.sideToMove),
-        castlingRights(pos.castlingRights),
-        enPassantRights(pos.enPassantRights),
-        fiftyMoveNum(pos.fiftyMoveNum),
-        halfmoveNum(pos.halfmoveNum),
-        gameover(pos.gameover),
-        undoStack(pos.undoStack)
-    {
-    };
+    Position() { mailbox.fill(NO_TYPE); }
+    Position(const Position& pos) = default;
     std::array<Bitboard, NUM_COLOURS> bbByColour{};
     std::array<Bitboard, NUM_PIECE_TYPES> bbByType{};   //PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING
     Bitboard occupancy{ 0 };
+    // Piece type on each square (NO_TYPE if empty), kept in sync with the
+    // bitboards so a lookup is a single load.
+    std::array<PieceType, NUM_SQUARES> mailbox{};
     // Game state information
     Colour sideToMove{ WHITE };
     int castlingRights = 0;
     Square enPassantRights{ NO_SQ };
     int fiftyMoveNum{ 0 };
     int halfmoveNum{ 0 };
-    bool gameover = false;
-    // Vector of hashed positions for 3 move draw
-    std::vector<uint64_t> hashes;
-    // Vector of unrestorable information for unmaking moves.
-    std::vector<StateInfo> undoStack;
+    // Zobrist key of the position, kept up to date by make/unmake.
+    uint64_t key{ 0 };
+    // Zobrist key of the pawns alone, for the pawn structure cache.
+    uint64_t pawnKey{ 0 };
+    // Material plus piece-square totals from white's point of view, and the
+    // game phase (see psqt.h), kept up to date by add/remove/make/unmake.
+    int psqtMg{ 0 };
+    int psqtEg{ 0 };
+    int phase{ 0 };
+    // Plies made since the position was set up; indexes the ring buffers.
+    int gamePly{ 0 };
+    // Keys of the positions reached, for repetition detection.
+    std::array<uint64_t, HISTORY_SIZE> keyHistory;
+    // Unrestorable information for unmaking moves.
+    std::array<StateInfo, HISTORY_SIZE> undoStack;
 public:
     void reset();
     std::string pretty_cb() const;
@@ -55,15 +98,38 @@ public:
     void addPiece(PieceType piece, Colour colour, Square sq);
     void removePiece(Square sq);
     void removePiece(Square sq, PieceType);
-    PieceType figurePieceFromSq(Square sq);
+    PieceType figurePieceFromSq(Square sq) const { return mailbox[sq]; }
+    void psqtAdd(Colour co, PieceType pt, Square sq) {
+        psqtMg += psqt.mg[co][pt][sq];
+        psqtEg += psqt.eg[co][pt][sq];
+        phase += PHASE_WEIGHTS[pt];
+    }
+    void psqtRemove(Colour co, PieceType pt, Square sq) {
+        psqtMg -= psqt.mg[co][pt][sq];
+        psqtEg -= psqt.eg[co][pt][sq];
+        phase -= PHASE_WEIGHTS[pt];
+    }
+    void psqtMove(Colour co, PieceType pt, Square from, Square to) {
+        psqtMg += psqt.mg[co][pt][to] - psqt.mg[co][pt][from];
+        psqtEg += psqt.eg[co][pt][to] - psqt.eg[co][pt][from];
+    }
     void makeCastlingMove(Move mv);
     void unmakeCastlingMove(Move mv);
     // --- Move making/unmaking ---
     void makeMove(Move mv);
     void makeMoveFronStr_UCI(std::string usi_str);
     void unmakeMove(Move mv);
+    // Passes the turn, for null-move pruning. Clears en passant rights and
+    // starts a new repetition window, as no line through a null move is a
+    // real game.
+    void makeNullMove();
+    void unmakeNullMove();
     void setStartingPosition();
-    uint64_t calculateHash();
+    // Computes the Zobrist key from scratch.
+    uint64_t calculateHash() const;
+    // Number of earlier occurrences of the current position, counting back
+    // only as far as the last irreversible move.
+    int repetitionCount() const;
 
     
 
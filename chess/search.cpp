@@ -0,0 +1,530 @@
+#include "search.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+// Mate scores are stored relative to the node rather than the root, so a
+// transposition reached at a different ply still reports the right distance.
+static int scoreToTT(int score, int ply)
+{
+    if (score >= MATE_BOUND)
+        return score + ply;
+    if (score <= -MATE_BOUND)
+        return score - ply;
+    return score;
+}
+
+static int scoreFromTT(int score, int ply)
+{
+    if (score >= MATE_BOUND)
+        return score - ply;
+    if (score <= -MATE_BOUND)
+        return score + ply;
+    return score;
+}
+
+// Draw by the fifty-move rule or threefold repetition.
+static bool isDraw(const Position& pos)
+{
+    return pos.fiftyMoveNum >= 100 || (pos.fiftyMoveNum >= 4 && pos.repetitionCount() >= 2);
+}
+
+// Depth skipping pattern for helper threads: helper i (counting from 1)
+// uses entry (i - 1) % 20 and skips a depth when
+// ((depth + SKIP_PHASE) / SKIP_SIZE) is odd.
+static constexpr int SKIP_SIZE[20]{ 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+static constexpr int SKIP_PHASE[20]{ 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+void Search::setThreads(size_t count)
+{
+    count = std::max<size_t>(1, std::min<size_t>(count, MAX_THREADS));
+    workers.clear();
+    for (size_t i = 0; i < count; i++)
+        workers.push_back(std::make_unique<SearchWorker>(*this, i));
+    helpers.reset();
+    if (count > 1)
+        helpers = std::make_unique<ThreadPool>(count - 1);
+}
+
+void Search::clear()
+{
+    for (auto& w : workers)
+        w->clearHistory();
+}
+
+void Search::setParams(const SearchParams& p)
+{
+    searchParams = p;
+    for (int d = 0; d < LMR_TABLE_SIZE; d++) {
+        for (int m = 0; m < LMR_TABLE_SIZE; m++) {
+            reductions[d][m] = (d == 0 || m == 0) ? 0
+                : static_cast<int>((p.lmrBase + std::log(d) * std::log(m) * 10000 / p.lmrDivisor) / 100);
+        }
+    }
+}
+
+void Search::setReporters(IterationReporter iteration, CurrMoveReporter currMove)
+{
+    reportIteration = std::move(iteration);
+    reportCurrMove = std::move(currMove);
+}
+
+void Search::prepare(const SearchLimits& searchLimits, Colour us)
+{
+    limits = searchLimits;
+    pondering = limits.ponder;
+    stopped = false;
+    timeManager.start(limits, us);
+}
+
+// The hash move of the position after mv, if it is legal there. Used when the
+// PV was cut short (by a hash cutoff, say) and has no reply to ponder on.
+static Move ponderFromTT(Position& pos, Move mv)
+{
+    if (!mv)
+        return 0;
+    Move ponder{ 0 };
+    pos.makeMove(mv);
+    TTData tte;
+    if (TT.probe(pos.key, tte) && tte.move) {
+        const Movelist replies = generateLegalMoves(pos);
+        if (std::find(replies.begin(), replies.end(), tte.move) != replies.end())
+            ponder = tte.move;
+    }
+    pos.unmakeMove(mv);
+    return ponder;
+}
+
+SearchResult Search::think(Position& pos)
+{
+    TT.newSearch();
+    const int maxDepth{ limits.depth > 0 ? std::min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1 };
+
+    // Counters are cleared up front: a helper may start late, and the node
+    // limit must not see the previous search's counts.
+    for (auto& w : workers)
+        w->clearNodes();
+    std::vector<SearchResult> results(workers.size());
+    for (size_t i = 1; i < workers.size(); i++) {
+        helpers->submit([this, &results, i, maxDepth, copy = pos]() mutable {
+            results[i] = workers[i]->iterate(copy, maxDepth);
+            });
+    }
+    results[0] = workers[0]->iterate(pos, maxDepth);
+    // UCI forbids sending bestmove during an infinite or ponder search before
+    // the GUI says so, even if the search has nothing left to do.
+    while (!stopped && (limits.infinite || pondering))
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // The main thread decides when the search is over.
+    stopped = true;
+    if (helpers)
+        helpers->wait();
+
+    // Prefer the thread that completed the deepest iteration.
+    size_t best{ 0 };
+    for (size_t i = 1; i < results.size(); i++) {
+        if (results[i].depth > results[best].depth)
+            best = i;
+    }
+    SearchResult result{ results[best] };
+    result.nodes = nodeCount();
+    // The main thread has only reported its own iterations.
+    if (best != 0 && reportIteration)
+        reportIteration(result);
+    result.ponderMove = result.pv.size() > 1 ? result.pv[1] : ponderFromTT(pos, result.bestMove);
+    return result;
+}
+
+uint64_t Search::nodeCount() const
+{
+    uint64_t total{ 0 };
+    for (const auto& w : workers)
+        total += w->nodeCount();
+    return total;
+}
+
+void Search::checkLimits()
+{
+    if ((limits.nodes && nodeCount() >= limits.nodes) || (!pondering && timeManager.hardExpired()))
+        stopped = true;
+}
+
+bool SearchWorker::skipDepth(int depth) const
+{
+    if (id == 0)
+        return false;
+    const size_t i{ (id - 1) % 20 };
+    return ((depth + SKIP_PHASE[i]) / SKIP_SIZE[i]) % 2 != 0;
+}
+
+SearchResult SearchWorker::iterate(Position& pos, int maxDepth)
+{
+    SearchResult result{};
+    rootBest = 0;
+    history->age();
+    std::memset(killers, 0, sizeof(killers));
+    rootMoves = generateLegalMoves(pos);
+    if (rootMoves.empty())
+        return result;
+    if (NNUE.loaded())
+        NNUE.refresh(accumulators[0], pos);
+    // Always have a move to play, even if the first iteration is cut short.
+    result.bestMove = rootMoves[0];
+    const SearchLimits& limits{ search.limits };
+    int score{ 0 };
+    for (int d = 1; d <= maxDepth; d++) {
+        if (skipDepth(d) && d < maxDepth)
+            continue;
+        rootDepth = d;
+        selDepth = 0;
+        score = (result.depth == 0) ? searchRoot(pos, d, -INFINITE_EVALUATION, INFINITE_EVALUATION)
+                                    : aspirationSearch(pos, d, score);
+        // Results of an interrupted iteration are not trusted.
+        if (search.stopped.load(std::memory_order_relaxed))
+            break;
+        result.bestMove = rootBest;
+        result.score = score;
+        result.depth = d;
+        result.selDepth = selDepth;
+        result.time = search.timeManager.elapsed();
+        result.pv.assign(pvTable[0], pvTable[0] + pvLength[0]);
+        if (result.pv.empty() || result.pv[0] != rootBest)
+            result.pv.assign(1, rootBest);
+        if (id == 0 && search.reportIteration) {
+            result.nodes = search.nodeCount();
+            search.reportIteration(result);
+        }
+        // A single legal move needs no search beyond a score for the GUI.
+        if (id == 0 && !search.pondering && (search.timeManager.softExpired()
+            || (rootMoves.size() == 1 && !limits.infinite && limits.depth == 0)))
+            break;
+    }
+    result.nodes = nodes;
+    return result;
+}
+
+int SearchWorker::aspirationSearch(Position& pos, int depth, int prevScore)
+{
+    // Search a narrow window around the previous iteration's score, widening
+    // on the failing side until the true score falls inside.
+    int delta{ ASPIRATION_WINDOW };
+    int alpha{ std::max(prevScore - delta, -INFINITE_EVALUATION) };
+    int beta{ std::min(prevScore + delta, INFINITE_EVALUATION) };
+    while (true) {
+        int score = searchRoot(pos, depth, alpha, beta);
+        if (search.stopped.load(std::memory_order_relaxed)) {
+            return score;
+        }
+        if (score <= alpha) {
+            alpha = std::max(score - delta, -INFINITE_EVALUATION);
+        }
+        else if (score >= beta) {
+            beta = std::min(score + delta, INFINITE_EVALUATION);
+        }
+        else {
+            return score;
+        }
+        delta *= 2;
+    }
+}
+
+int SearchWorker::searchRoot(Position& pos, int depth, int alpha, int beta)
+{
+    // Try the best move of the previous iteration first.
+    if (rootBest) {
+        rootMoves.swap(0, std::find(rootMoves.begin(), rootMoves.end(), rootBest) - rootMoves.begin());
+    }
+    const int origAlpha{ alpha };
+    int bestScore{ -INFINITE_EVALUATION };
+    Move bestMove{ rootMoves[0] };
+    pvLength[0] = 0;
+    for (size_t i = 0; i < rootMoves.size(); i++) {
+        Move mv{ rootMoves[i] };
+        if (id == 0 && search.reportCurrMove && search.timeManager.elapsed() >= CURRMOVE_DELAY_MS)
+            search.reportCurrMove(depth, mv, static_cast<int>(i + 1));
+        makeMove(pos, mv, 0);
+        int score{ 0 };
+        if (i == 0) {
+            score = -negamax(pos, depth - 1, 1, -beta, -alpha);
+        }
+        else {
+            // PVS: prove the move is worse with a null window, re-search if not.
+            score = -negamax(pos, depth - 1, 1, -alpha - 1, -alpha);
+            if (score > alpha && score < beta)
+                score = -negamax(pos, depth - 1, 1, -beta, -alpha);
+        }
+        pos.unmakeMove(mv);
+        if (search.stopped.load(std::memory_order_relaxed))
+            return 0;
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = mv;
+            if (score > alpha) {
+                alpha = score;
+                updatePv(0, mv);
+            }
+            if (score >= beta)
+                break;
+        }
+    }
+    // A fail-low result says nothing about which move is best.
+    if (bestScore > origAlpha || !rootBest)
+        rootBest = bestMove;
+    const Bound bound{ bestScore >= beta ? BOUND_LOWER : (bestScore > origAlpha ? BOUND_EXACT : BOUND_UPPER) };
+    TT.store(pos.key, rootBest, scoreToTT(bestScore, 0), 0, depth, bound);
+    return bestScore;
+}
+
+int SearchWorker::negamax(Position& pos, int depth, int ply, int alpha, int beta)
+{
+    pvLength[ply] = ply;
+    if (depth <= 0)
+        return qsearch(pos, ply, alpha, beta);
+    if (countNode())
+        return 0;
+    if (isDraw(pos))
+        return 0;
+    selDepth = std::max(selDepth, ply);
+    if (ply >= MAX_PLY)
+        return evaluateLeaf(pos, ply, alpha, beta);
+
+    const SearchParams& params{ search.searchParams };
+    const Colour us{ pos.sideToMove };
+    const bool pvNode{ beta - alpha > 1 };
+    const int origAlpha{ alpha };
+    TTData tte;
+    const bool ttHit{ TT.probe(pos.key, tte) };
+    if (ttHit && !pvNode && tte.depth >= depth) {
+        const int ttScore{ scoreFromTT(tte.score, ply) };
+        if (tte.bound == BOUND_EXACT
+            || (tte.bound == BOUND_LOWER && ttScore >= beta)
+            || (tte.bound == BOUND_UPPER && ttScore <= alpha))
+            return ttScore;
+    }
+
+    const bool inCheck{ isInCheck(us, pos) };
+    const int staticEval{ inCheck ? -INFINITE_EVALUATION : evaluateLeaf(pos, ply, -INFINITE_EVALUATION, INFINITE_EVALUATION) };
+    if (!pvNode && !inCheck) {
+        // Razoring: far below alpha, only a tactic can help, and quiescence
+        // would find it.
+        if (params.razoring && depth <= params.razorMaxDepth
+            && staticEval + params.razorMargin * depth <= alpha) {
+            const int score{ qsearch(pos, ply, alpha, alpha + 1) };
+            if (score <= alpha)
+                return score;
+        }
+        // Reverse futility: far above beta, assume a quiet move keeps it so.
+        if (params.reverseFutility && depth <= params.rfpMaxDepth
+            && staticEval - params.rfpMargin * depth >= beta && std::abs(beta) < MATE_BOUND)
+            return staticEval;
+        // Null move. Not twice in a row, and not with only pawns left, where
+        // zugzwang is common.
+        const Bitboard pieces{ pos.bbByColour[us] & ~(pos.bbByType[PAWN] | pos.bbByType[KING]) };
+        if (params.nullMove && depth >= params.nullMoveMinDepth && staticEval >= beta && pieces
+            && played[ply - 1].piece != NO_TYPE && ply >= nullMoveMinPly && std::abs(beta) < MATE_BOUND) {
+            const int reducedDepth{ depth - 1 - params.nullMoveBase - depth / params.nullMoveDivisor };
+            makeNullMove(pos, ply);
+            int score{ -negamax(pos, reducedDepth, ply + 1, -beta, -beta + 1) };
+            pos.unmakeNullMove();
+            if (search.stopped.load(std::memory_order_relaxed))
+                return 0;
+            if (score >= beta) {
+                // A mate found after passing isn't a proven mate.
+                if (score >= MATE_BOUND)
+                    score = beta;
+                if (depth < params.nullMoveVerifyDepth || nullMoveMinPly)
+                    return score;
+                nullMoveMinPly = ply + 3 * std::max(reducedDepth, 0) / 4;
+                const int verified{ negamax(pos, reducedDepth, ply, beta - 1, beta) };
+                nullMoveMinPly = 0;
+                if (verified >= beta)
+                    return score;
+            }
+        }
+    }
+
+    Movelist mvlist = generateLegalMoves(pos);
+    if (mvlist.empty()) {
+        // Checkmate (prefer the shortest mate) or stalemate.
+        return inCheck ? -CHECKMATE_EVALUATION + ply : 0;
+    }
+    MovePicker picker(pos, mvlist, ttHit ? tte.move : Move(0), killers[ply],
+        ply > 0 ? played[ply - 1] : PieceTo{}, *history);
+    Movelist quietsTried;
+    // Quiet moves that can't raise the score to alpha near the leaves.
+    const bool futile{ params.futility && !pvNode && !inCheck && depth <= params.futilityMaxDepth
+        && staticEval + params.futilityBase + params.futilityMargin * depth <= alpha };
+    int bestScore{ -INFINITE_EVALUATION };
+    Move bestMove{ 0 };
+    int moveCount{ 0 };
+    for (Move mv = picker.next(); mv; mv = picker.next()) {
+        const bool quiet{ !isCapture(pos, mv) && !isPromotion(mv) };
+        const bool badCapture{ !quiet && !seeGE(pos, mv, 0) };
+        const bool killer{ mv == killers[ply][0] || mv == killers[ply][1] };
+        makeMove(pos, mv, ply);
+        const bool givesCheck{ isInCheck(pos.sideToMove, pos) };
+        if (futile && quiet && !givesCheck && bestScore > -MATE_BOUND) {
+            pos.unmakeMove(mv);
+            continue;
+        }
+        TT.prefetch(pos.key);
+        moveCount++;
+        // Extensions are capped so that perpetual checks can't blow up the
+        // depth.
+        const int newDepth{ depth - 1 + (params.checkExtensions && givesCheck && ply < 2 * rootDepth) };
+        int score{ 0 };
+        if (moveCount == 1) {
+            score = -negamax(pos, newDepth, ply + 1, -beta, -alpha);
+        }
+        else {
+            int reduction{ 0 };
+            if (params.lmr && depth >= 3 && moveCount > 2 && !inCheck && !givesCheck && (quiet || badCapture)) {
+                reduction = search.reductions[std::min(depth, LMR_TABLE_SIZE - 1)][std::min(moveCount, LMR_TABLE_SIZE - 1)];
+                reduction -= pvNode + killer;
+                reduction = std::clamp(reduction, 0, newDepth - 1);
+            }
+            score = -negamax(pos, newDepth - reduction, ply + 1, -alpha - 1, -alpha);
+            if (reduction > 0 && score > alpha)
+                score = -negamax(pos, newDepth, ply + 1, -alpha - 1, -alpha);
+            if (score > alpha && score < beta)
+                score = -negamax(pos, newDepth, ply + 1, -beta, -alpha);
+        }
+        pos.unmakeMove(mv);
+        if (search.stopped.load(std::memory_order_relaxed))
+            return 0;
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = mv;
+            if (score > alpha) {
+                alpha = score;
+                if (pvNode)
+                    updatePv(ply, mv);
+            }
+            if (score >= beta) {
+                if (quiet)
+                    updateQuietStats(pos, ply, depth, mv, quietsTried);
+                break;
+            }
+        }
+        if (quiet)
+            quietsTried.push_back(mv);
+    }
+    const Bound bound{ bestScore >= beta ? BOUND_LOWER : (bestScore > origAlpha ? BOUND_EXACT : BOUND_UPPER) };
+    TT.store(pos.key, bound == BOUND_UPPER ? Move(0) : bestMove, scoreToTT(bestScore, ply), 0, depth, bound);
+    return bestScore;
+}
+
+int SearchWorker::qsearch(Position& pos, int ply, int alpha, int beta)
+{
+    pvLength[ply] = ply;
+    if (countNode())
+        return 0;
+    if (isDraw(pos))
+        return 0;
+    selDepth = std::max(selDepth, ply);
+    if (ply >= MAX_PLY)
+        return evaluateLeaf(pos, ply, alpha, beta);
+
+    // In check every evasion is searched and standing pat isn't allowed;
+    // otherwise the side to move may decline all captures.
+    const bool inCheck{ isInCheck(pos.sideToMove, pos) };
+    int bestScore{ -INFINITE_EVALUATION };
+    int standPat{ 0 };
+    if (!inCheck) {
+        standPat = evaluateLeaf(pos, ply, alpha, beta);
+        if (standPat >= beta)
+            return standPat;
+        if (standPat > alpha)
+            alpha = standPat;
+        bestScore = standPat;
+    }
+    Movelist mvlist = inCheck ? generateLegalMoves(pos) : generateLegalCaptures(pos);
+    if (inCheck && mvlist.empty())
+        return -CHECKMATE_EVALUATION + ply;
+    MovePicker picker(pos, mvlist, 0, killers[ply], ply > 0 ? played[ply - 1] : PieceTo{}, *history);
+    for (Move mv = picker.next(); mv; mv = picker.next()) {
+        if (!inCheck) {
+            if (isPromotion(mv) && getPromotionType(mv) != QUEEN)
+                continue;
+            // Delta pruning; promotions can swing too much to be pruned.
+            const PieceType victim{ isEnPassant(mv) ? PAWN : pos.mailbox[(mv >> 6) & 63] };
+            if (!isPromotion(mv) && standPat + PIECE_VALUES[victim] + DELTA_MARGIN <= alpha)
+                continue;
+            // Captures that lose material by exchange are not worth a look.
+            if (!seeGE(pos, mv, 0))
+                continue;
+        }
+        makeMove(pos, mv, ply);
+        const int score{ -qsearch(pos, ply + 1, -beta, -alpha) };
+        pos.unmakeMove(mv);
+        if (search.stopped.load(std::memory_order_relaxed))
+            return 0;
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                updatePv(ply, mv);
+            }
+            if (score >= beta)
+                break;
+        }
+    }
+    return bestScore;
+}
+
+bool SearchWorker::countNode()
+{
+    const uint64_t n{ nodes.load(std::memory_order_relaxed) + 1 };
+    nodes.store(n, std::memory_order_relaxed);
+    if ((n & (NODE_CHECK_INTERVAL - 1)) == 0 || n == search.limits.nodes)
+        search.checkLimits();
+    return search.stopped.load(std::memory_order_relaxed);
+}
+
+void SearchWorker::updateQuietStats(const Position& pos, int ply, int depth, Move best, const Movelist& quietsTried)
+{
+    const Colour us{ pos.sideToMove };
+    const PieceTo prev{ ply > 0 ? played[ply - 1] : PieceTo{} };
+    const int bonus{ historyBonus(depth) };
+    if (killers[ply][0] != best) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = best;
+    }
+    history->setCounterMove(us, prev, best);
+    history->update(us, best, pieceTo(pos, best), prev, bonus);
+    for (Move mv : quietsTried)
+        history->update(us, mv, pieceTo(pos, mv), prev, -bonus);
+}
+
+void SearchWorker::updatePv(int ply, Move mv)
+{
+    pvTable[ply][ply] = mv;
+    for (int i = ply + 1; i < pvLength[ply + 1]; i++)
+        pvTable[ply][i] = pvTable[ply + 1][i];
+    pvLength[ply] = std::max(pvLength[ply + 1], ply + 1);
+}
+
+void SearchWorker::makeNullMove(Position& pos, int ply)
+{
+    played[ply] = PieceTo{};
+    if (NNUE.loaded() && ply < MAX_PLY)
+        accumulators[ply + 1] = accumulators[ply];
+    pos.makeNullMove();
+}
+
+void SearchWorker::makeMove(Position& pos, Move mv, int ply)
+{
+    played[ply] = pieceTo(pos, mv);
+    if (NNUE.loaded() && ply < MAX_PLY)
+        NNUE.update(accumulators[ply + 1], accumulators[ply], pos, mv);
+    pos.makeMove(mv);
+}
+
+int SearchWorker::evaluateLeaf(const Position& pos, int ply, int alpha, int beta)
+{
+    if (NNUE.loaded())
+        return NNUE.evaluate(accumulators[ply], pos.sideToMove);
+    return evaluate(pos, alpha, beta, pawnTable);
+}
@@ -0,0 +1,209 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "position.h"
+#include "movegen.h"
+#include "evaluation.h"
+#include "nnue.h"
+#include "movepick.h"
+#include "see.h"
+#include "move.h"
+#include "timeman.h"
+#include "tt.h"
+#include "threadpool.h"
+
+// === search.h ===
+// Iterative deepening negamax alpha-beta search with principal variation
+// search (PVS) and aspiration windows at the root, on one or more threads.
+// Leaves are resolved by a quiescence search over captures and promotions.
+// Selective techniques (null-move pruning, late-move reductions, futility
+// pruning, razoring, check extensions) are governed by SearchParams.
+// Scores are in centipawns from the point of view of the side to move.
+
+constexpr int MAX_PLY{ 128 };
+const int INFINITE_EVALUATION = 2 * CHECKMATE_EVALUATION;
+// Any score beyond this bound is a forced mate.
+const int MATE_BOUND = CHECKMATE_EVALUATION - MAX_PLY;
+// Half-width of the first aspiration window around the previous score.
+const int ASPIRATION_WINDOW = 50;
+// The clock and node limit are polled once per this many nodes (power of 2).
+const uint64_t NODE_CHECK_INTERVAL = 2048;
+// Delta pruning: a capture is skipped in quiescence if even winning the
+// captured piece plus this margin can't bring the score up to alpha.
+const int DELTA_MARGIN = 200;
+
+// Depths and move numbers beyond this share the last row of the late-move
+// reduction table.
+constexpr int LMR_TABLE_SIZE{ 64 };
+
+// Upper bound for the UCI Threads option.
+constexpr int MAX_THREADS{ 256 };
+
+// Root moves are reported as "currmove" only once a search has run this long,
+// so that short searches don't flood the output.
+constexpr int64_t CURRMOVE_DELAY_MS{ 3000 };
+
+struct SearchResult {
+    Move bestMove{ 0 };
+    Move ponderMove{ 0 };   // expected reply, 0 if unknown
+    int score{ 0 };
+    int depth{ 0 };
+    int selDepth{ 0 };      // deepest ply reached, quiescence included
+    uint64_t nodes{ 0 };
+    int64_t time{ 0 };      // ms from the start until this depth completed
+    std::vector<Move> pv;   // principal variation, starting with bestMove
+};
+
+// Progress reports, called on the searching thread: after each iteration the
+// main thread completes, and for each root move it starts searching once
+// CURRMOVE_DELAY_MS have passed.
+using IterationReporter = std::function<void(const SearchResult&)>;
+using CurrMoveReporter = std::function<void(int depth, Move mv, int moveNumber)>;
+
+// Switches and parameters of the selective search. Each technique can be
+// turned off from UCI to measure its effect on nodes-to-depth.
+struct SearchParams {
+    // Null-move pruning: give the opponent a free move; if a search reduced
+    // by nullMoveBase + depth / nullMoveDivisor still fails high, so will
+    // the real moves. From nullMoveVerifyDepth on a fail-high is verified by
+    // a reduced search without null moves, which guards against zugzwang.
+    bool nullMove{ true };
+    int nullMoveMinDepth{ 3 };
+    int nullMoveBase{ 3 };
+    int nullMoveDivisor{ 4 };
+    int nullMoveVerifyDepth{ 12 };
+    // Late-move reductions: late quiet moves and losing captures are
+    // searched to reduced depth first, by
+    // lmrBase / 100 + ln(depth) * ln(moveNumber) / (lmrDivisor / 100) plies.
+    bool lmr{ true };
+    int lmrBase{ 75 };
+    int lmrDivisor{ 225 };
+    // Reverse futility: return the static evaluation when it beats beta by
+    // more than rfpMargin per ply of remaining depth.
+    bool reverseFutility{ true };
+    int rfpMaxDepth{ 7 };
+    int rfpMargin{ 80 };
+    // Futility pruning: skip quiet moves near the leaves when the static
+    // evaluation is more than futilityBase + futilityMargin * depth below
+    // alpha.
+    bool futility{ true };
+    int futilityMaxDepth{ 6 };
+    int futilityBase{ 60 };
+    int futilityMargin{ 100 };
+    // Razoring: drop straight into quiescence when the static evaluation is
+    // more than razorMargin * depth below alpha.
+    bool razoring{ true };
+    int razorMaxDepth{ 3 };
+    int razorMargin{ 250 };
+    // Search one ply deeper after a checking move.
+    bool checkExtensions{ true };
+};
+
+class Search;
+
+// One thread of the search. Every worker runs its own iterative deepening on
+// its own copy of the position; the workers only share the transposition
+// table and the stop flag (Lazy SMP). Worker 0 runs on the calling thread
+// and is the one that decides when to stop between iterations.
+class SearchWorker {
+public:
+    SearchWorker(Search& owner, size_t index)
+        : search(owner), id(index), accumulators(new Accumulator[MAX_PLY + 1]), history(new History) {}
+    // Iterative deepening up to maxDepth or until the search is stopped.
+    SearchResult iterate(Position& pos, int maxDepth);
+    uint64_t nodeCount() const { return nodes.load(std::memory_order_relaxed); }
+    void clearNodes() { nodes.store(0, std::memory_order_relaxed); }
+    // Forgets all move ordering statistics, for a new game.
+    void clearHistory() { history->clear(); }
+
+private:
+    Search& search;
+    const size_t id;
+    std::atomic<uint64_t> nodes{ 0 };
+    Movelist rootMoves;
+    Move rootBest{ 0 };
+    int rootDepth{ 0 };
+    int selDepth{ 0 };
+    // Triangular principal variation table: pvTable[ply] holds the best line
+    // found from ply, of pvLength[ply] - ply moves.
+    Move pvTable[MAX_PLY + 1][MAX_PLY + 1]{};
+    int pvLength[MAX_PLY + 1]{};
+    // Null moves are disabled below this ply while a null-move fail-high is
+    // being verified.
+    int nullMoveMinPly{ 0 };
+    PawnTable pawnTable;
+    // NNUE accumulator of the position at each ply, when a network is loaded.
+    std::unique_ptr<Accumulator[]> accumulators;
+    // Move ordering statistics; see movepick.h.
+    std::unique_ptr<History> history;
+    Move killers[MAX_PLY + 1][2]{};
+    // The move made at each ply, for counter moves and continuation history.
+    PieceTo played[MAX_PLY + 1]{};
+
+    // Helpers skip some depths so that they spread over different iterations
+    // instead of all searching the same tree as the main thread.
+    bool skipDepth(int depth) const;
+    int aspirationSearch(Position& pos, int depth, int prevScore);
+    int searchRoot(Position& pos, int depth, int alpha, int beta);
+    int negamax(Position& pos, int depth, int ply, int alpha, int beta);
+    int qsearch(Position& pos, int ply, int alpha, int beta);
+    // Counts a node and polls the limits every NODE_CHECK_INTERVAL nodes.
+    // Returns true if the search has been stopped.
+    bool countNode();
+    // Rewards a quiet move that caused a cutoff and penalises the quiet
+    // moves searched before it.
+    void updateQuietStats(const Position& pos, int ply, int depth, Move best, const Movelist& quietsTried);
+    // Makes mv the first move of ply's PV, followed by the child's PV.
+    void updatePv(int ply, Move mv);
+    // Makes mv at ply, first recording it and deriving the next ply's
+    // accumulator.
+    void makeMove(Position& pos, Move mv, int ply);
+    void makeNullMove(Position& pos, int ply);
+    int evaluateLeaf(const Position& pos, int ply, int alpha, int beta);
+};
+
+class Search {
+public:
+    Search() { setThreads(1); setParams(SearchParams{}); }
+    // Starts the clock and clears the stop flag for the next think(). Called
+    // on the thread that received "go", before the search thread is started,
+    // so a "stop" arriving right after "go" is never lost.
+    void prepare(const SearchLimits& limits, Colour us);
+    // Searches the position with iterative deepening until a limit is hit and
+    // returns the best move of the deepest completed iteration of any thread.
+    // An infinite or ponder search only returns once it has been stopped.
+    SearchResult think(Position& pos);
+    // Safe to call from any thread while think() runs.
+    void stop() { stopped = true; }
+    // The opponent played the expected move: the clock now applies.
+    void ponderhit() { pondering = false; }
+    void setThreads(size_t count);
+    size_t threadCount() const { return workers.size(); }
+    // Clears the move ordering statistics of every thread, for a new game.
+    void clear();
+    const SearchParams& params() const { return searchParams; }
+    // Not to be called while a search is running.
+    void setParams(const SearchParams& p);
+    void setReporters(IterationReporter iteration, CurrMoveReporter currMove);
+
+private:
+    friend class SearchWorker;
+
+    SearchLimits limits;
+    TimeManager timeManager;
+    std::atomic<bool> stopped{ false };
+    std::atomic<bool> pondering{ false };     // time limits are ignored while set
+    std::vector<std::unique_ptr<SearchWorker>> workers;
+    std::unique_ptr<ThreadPool> helpers;    // runs workers 1..n-1
+    SearchParams searchParams;
+    IterationReporter reportIteration;
+    CurrMoveReporter reportCurrMove;
+    // Late-move reduction in plies, by depth and move number.
+    int reductions[LMR_TABLE_SIZE][LMR_TABLE_SIZE];
+
+    uint64_t nodeCount() const;
+    void checkLimits();
+};
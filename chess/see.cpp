@@ -0,0 +1,132 @@
+#include "see.h"
+#include <algorithm>
+#include "evaluation.h"
+#include "movegen.h"
+
+// Longest possible exchange: every piece on the board captures once.
+constexpr int MAX_EXCHANGE{ 32 };
+
+// The first capture of the exchange: what it wins, which piece then stands
+// on the square, and the occupancy after it.
+struct FirstCapture {
+    int gain;
+    PieceType attacker;
+    Bitboard occupancy;
+};
+
+static FirstCapture firstCapture(const Position& pos, Move mv)
+{
+    const Square fromSq{ static_cast<Square>(mv & 63) };
+    const Square toSq{ static_cast<Square>((mv >> 6) & 63) };
+    FirstCapture first{ 0, pos.mailbox[fromSq], pos.occupancy ^ (1ULL << fromSq) };
+    if (isEnPassant(mv)) {
+        first.gain = PIECE_VALUES[PAWN];
+        first.occupancy ^= 1ULL << (pos.sideToMove == WHITE ? toSq - 8 : toSq + 8);
+    }
+    else if (pos.mailbox[toSq] != NO_TYPE) {
+        first.gain = PIECE_VALUES[pos.mailbox[toSq]];
+    }
+    if (isPromotion(mv)) {
+        first.gain += PIECE_VALUES[getPromotionType(mv)] - PIECE_VALUES[PAWN];
+        first.attacker = getPromotionType(mv);
+    }
+    first.occupancy |= 1ULL << toSq;
+    return first;
+}
+
+// Every piece of either colour attacking sq through the given occupancy.
+static Bitboard allAttackers(Square sq, const Position& pos, Bitboard occupancy)
+{
+    return (attacksTo(sq, WHITE, pos, occupancy) | attacksTo(sq, BLACK, pos, occupancy)) & occupancy;
+}
+
+// Least valuable piece of co in attackers, or NO_TYPE if there is none.
+static PieceType leastValuable(const Position& pos, Bitboard attackers, Colour co, Bitboard& piece)
+{
+    const Bitboard own{ attackers & pos.bbByColour[co] };
+    for (int pt = PAWN; pt <= KING; pt++) {
+        if (const Bitboard bb = own & pos.bbByType[pt]) {
+            piece = bb & (0 - bb);
+            return static_cast<PieceType>(pt);
+        }
+    }
+    return NO_TYPE;
+}
+
+int see(const Position& pos, Move mv)
+{
+    if (isCastling(mv))
+        return 0;
+    const Square toSq{ static_cast<Square>((mv >> 6) & 63) };
+    FirstCapture first{ firstCapture(pos, mv) };
+    Bitboard occupancy{ first.occupancy };
+    Bitboard attackers{ allAttackers(toSq, pos, occupancy) };
+    PieceType onSquare{ first.attacker };
+    Colour side{ !pos.sideToMove };
+
+    // gain[d]: material for the side making capture d, if the exchange
+    // stopped right after it.
+    int gain[MAX_EXCHANGE];
+    int d{ 0 };
+    gain[0] = first.gain;
+    while (d + 1 < MAX_EXCHANGE) {
+        Bitboard piece{ 0 };
+        const PieceType pt{ leastValuable(pos, attackers, side, piece) };
+        if (pt == NO_TYPE)
+            break;
+        // The king can only recapture if nothing defends the square.
+        if (pt == KING && (attackers & pos.bbByColour[!side]))
+            break;
+        d++;
+        gain[d] = PIECE_VALUES[onSquare] - gain[d - 1];
+        occupancy ^= piece;
+        attackers = allAttackers(toSq, pos, occupancy);
+        onSquare = pt;
+        side = !side;
+    }
+    // Each side only continues the exchange if it pays.
+    while (d > 0) {
+        gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+        d--;
+    }
+    return gain[0];
+}
+
+bool seeGE(const Position& pos, Move mv, int threshold)
+{
+    if (isCastling(mv))
+        return 0 >= threshold;
+    const Square toSq{ static_cast<Square>((mv >> 6) & 63) };
+    FirstCapture first{ firstCapture(pos, mv) };
+    // swap is how far the side to move in the exchange is above the
+    // threshold if the piece on the square is taken, from its point of view.
+    int swap{ first.gain - threshold };
+    if (swap < 0)
+        return false;
+    swap = PIECE_VALUES[first.attacker] - swap;
+    if (swap <= 0)
+        return true;
+
+    Bitboard occupancy{ first.occupancy };
+    Bitboard attackers{ allAttackers(toSq, pos, occupancy) };
+    Colour side{ pos.sideToMove };
+    // 1 while the mover is winning the exchange so far.
+    bool result{ true };
+    while (true) {
+        side = !side;
+        Bitboard piece{ 0 };
+        const PieceType pt{ leastValuable(pos, attackers, side, piece) };
+        if (pt == NO_TYPE)
+            break;
+        result = !result;
+        if (pt == KING)
+            // Capturing with the king only works if the square is undefended.
+            return (attackers & pos.bbByColour[!side]) ? !result : result;
+        swap = PIECE_VALUES[pt] - swap;
+        if (swap < static_cast<int>(result))
+            break;
+        occupancy ^= piece;
+        attackers = allAttackers(toSq, pos, occupancy);
+    }
+    return result;
+}
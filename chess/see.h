@@ -0,0 +1,18 @@
+#pragma once
+#include "position.h"
+#include "move.h"
+
+// === see.h ===
+// Static exchange evaluation: the material outcome of the capture sequence
+// a move starts on its destination square, with each side recapturing with
+// its least valuable attacker and free to stop whenever continuing would
+// lose material. Works on bitboards alone: pieces are lifted off a copy of
+// the occupancy as they capture, which uncovers sliders behind them
+// (x-rays), and the position itself is never made or unmade.
+// Pins and checks are ignored, as usual.
+
+// Material won (or lost, if negative) by mv, in PIECE_VALUES units.
+int see(const Position& pos, Move mv);
+// True if see(pos, mv) >= threshold. Cheaper than see(), as it stops as soon
+// as the answer is known.
+bool seeGE(const Position& pos, Move mv, int threshold);
@@ -0,0 +1,113 @@
+#include "threadpool.h"
+#include <algorithm>
+
+namespace {
+// The pool and worker index of the calling thread, if it is a pool worker.
+thread_local const ThreadPool* currentPool{ nullptr };
+thread_local size_t currentWorker{ 0 };
+}
+
+void ThreadPool::resize(size_t threads)
+{
+    shutdown();
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    stopping = false;
+    for (size_t i = 0; i < threads; i++)
+        workers.push_back(std::make_unique<Worker>());
+    for (size_t i = 0; i < threads; i++)
+        workers[i]->thread = std::thread(&ThreadPool::run, this, i);
+}
+
+void ThreadPool::shutdown()
+{
+    if (workers.empty())
+        return;
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& w : workers)
+        w->thread.join();
+    workers.clear();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    // A task submitting subtasks keeps them on its own worker; they get
+    // stolen only if someone else runs out of work.
+    const size_t index{ currentPool == this ? currentWorker
+        : nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size() };
+    pending.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        workers[index]->tasks.push_back(std::move(task));
+    }
+    {
+        // Counted under the sleep mutex so a worker can't miss the wake-up
+        // between checking for work and going to sleep.
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queued.fetch_add(1, std::memory_order_relaxed);
+    }
+    workAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    allDone.wait(lock, [this] { return pending.load() == 0; });
+}
+
+bool ThreadPool::popLocal(size_t index, std::function<void()>& task)
+{
+    Worker& w{ *workers[index] };
+    std::lock_guard<std::mutex> lock(w.mutex);
+    if (w.tasks.empty())
+        return false;
+    task = std::move(w.tasks.back());
+    w.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(size_t index, std::function<void()>& task)
+{
+    for (size_t i = 1; i < workers.size(); i++)
+    {
+        Worker& victim{ *workers[(index + i) % workers.size()] };
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty())
+            continue;
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(size_t index)
+{
+    currentPool = this;
+    currentWorker = index;
+    std::function<void()> task;
+    while (true)
+    {
+        if (popLocal(index, task) || steal(index, task))
+        {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            task = nullptr;
+            if (pending.fetch_sub(1) == 1)
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                allDone.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        workAvailable.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping)
+            return;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// === threadpool.h ===
+// Fixed-size work-stealing thread pool for batch jobs.
+// Every worker owns a deque of tasks. A worker takes its own newest task
+// first (LIFO, good for locality when tasks submit subtasks) and, when its
+// deque is empty, steals the oldest task from another worker (FIFO, which
+// tends to take the biggest remaining pieces of work). Tasks submitted from
+// outside the pool are dealt out round-robin.
+
+class ThreadPool {
+public:
+    // A thread count of 0 means one thread per hardware thread.
+    explicit ThreadPool(size_t threads = 0) { resize(threads); }
+    ~ThreadPool() { shutdown(); }
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Waits for queued work, then restarts the pool with a new thread count.
+    void resize(size_t threads);
+    size_t size() const { return workers.size(); }
+    void submit(std::function<void()> task);
+    // Blocks until every submitted task, including tasks submitted by other
+    // tasks, has finished. Must not be called from inside a task.
+    void wait();
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+        std::thread thread;
+    };
+
+    void run(size_t index);
+    bool popLocal(size_t index, std::function<void()>& task);
+    bool steal(size_t index, std::function<void()>& task);
+    void shutdown();
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex sleepMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    std::atomic<size_t> queued{ 0 };     // tasks waiting in some deque
+    std::atomic<size_t> pending{ 0 };    // tasks submitted but not finished
+    std::atomic<size_t> nextWorker{ 0 };
+    bool stopping{ false };
+};
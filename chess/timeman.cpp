@@ -0,0 +1,29 @@
+#include "timeman.h"
+#include <algorithm>
+
+void TimeManager::start(const SearchLimits& limits, Colour us)
+{
+    startTime = std::chrono::steady_clock::now();
+    softLimit = -1;
+    hardLimit = -1;
+    if (limits.infinite)
+        return;
+    if (limits.moveTime >= 0) {
+        softLimit = hardLimit = std::max(limits.moveTime - MOVE_OVERHEAD, 1);
+        return;
+    }
+    if (limits.time[us] < 0)
+        return;
+    // Spread the remaining time over the moves left, then allow a single move
+    // to overrun its share while never touching the last quarter of the clock.
+    const int64_t available{ std::max(limits.time[us] - MOVE_OVERHEAD, 1) };
+    const int64_t movesToGo{ limits.movesToGo > 0 ? std::min(limits.movesToGo, DEFAULT_MOVES_TO_GO) : DEFAULT_MOVES_TO_GO };
+    const int64_t share{ available / movesToGo + limits.inc[us] * 3 / 4 };
+    hardLimit = std::max<int64_t>(std::min(share * 4, available * 3 / 4), 1);
+    softLimit = std::min(share, hardLimit);
+}
+
+int64_t TimeManager::elapsed() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
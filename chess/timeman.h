@@ -0,0 +1,41 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include "bitboard_lookup.h"
+
+// === timeman.h ===
+// Search limits from the UCI "go" command and the clock that enforces them.
+
+// Time reserved per move for GUI/network lag, in milliseconds.
+const int MOVE_OVERHEAD = 30;
+// Moves assumed left in the game when the GUI doesn't send movestogo.
+const int DEFAULT_MOVES_TO_GO = 40;
+
+struct SearchLimits {
+    // All times in milliseconds; -1 means not given.
+    int time[NUM_COLOURS]{ -1, -1 };
+    int inc[NUM_COLOURS]{ 0, 0 };
+    int movesToGo{ 0 };
+    int moveTime{ -1 };
+    int depth{ 0 };
+    uint64_t nodes{ 0 };
+    bool infinite{ false };
+    bool ponder{ false };
+};
+
+class TimeManager {
+public:
+    // Starts the clock and computes the soft and hard deadlines for the side
+    // to move. Soft: don't begin another iteration. Hard: abort the search.
+    void start(const SearchLimits& limits, Colour us);
+    int64_t elapsed() const;
+    bool softExpired() const { return softLimit >= 0 && elapsed() >= softLimit; }
+    bool hardExpired() const { return hardLimit >= 0 && elapsed() >= hardLimit; }
+    int64_t softLimitMs() const { return softLimit; }
+    int64_t hardLimitMs() const { return hardLimit; }
+
+private:
+    std::chrono::steady_clock::time_point startTime;
+    int64_t softLimit{ -1 };
+    int64_t hardLimit{ -1 };
+};
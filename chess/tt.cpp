@@ -0,0 +1,125 @@
+#include "tt.h"
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
+TranspositionTable TT;
+
+void TranspositionTable::resize(size_t megabytes)
+{
+    size_t count{ 1 };
+    while (count * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024)
+        count *= 2;
+    table.reset();
+    table.reset(new Bucket[count]);
+    bucketCount = count;
+    generation = 0;
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i < bucketCount; i++)
+    {
+        for (Entry& e : table[i].entries)
+        {
+            e.keyXorData.store(0, std::memory_order_relaxed);
+            e.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+uint64_t TranspositionTable::pack(Move mv, int score, int eval, int depth, Bound bound, uint8_t age)
+{
+    return static_cast<uint64_t>(mv)
+        | (static_cast<uint64_t>(static_cast<uint16_t>(score)) << 16)
+        | (static_cast<uint64_t>(static_cast<uint16_t>(eval)) << 32)
+        | (static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 48)
+        | (static_cast<uint64_t>(bound) << 56)
+        | (static_cast<uint64_t>(age) << 58);
+}
+
+TTData TranspositionTable::unpack(uint64_t data)
+{
+    TTData out;
+    out.move = static_cast<Move>(data & 0xFFFF);
+    out.score = static_cast<int16_t>((data >> 16) & 0xFFFF);
+    out.eval = static_cast<int16_t>((data >> 32) & 0xFFFF);
+    out.depth = depthOf(data);
+    out.bound = static_cast<Bound>((data >> 56) & 0x3);
+    return out;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData& out) const
+{
+    const Bucket& bucket{ bucketFor(key) };
+    for (const Entry& e : bucket.entries)
+    {
+        const uint64_t data{ e.data.load(std::memory_order_relaxed) };
+        if ((e.keyXorData.load(std::memory_order_relaxed) ^ data) == key && data)
+        {
+            out = unpack(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, Move mv, int score, int eval, int depth, Bound bound)
+{
+    Bucket& bucket{ bucketFor(key) };
+    Entry* replace{ &bucket.entries[0] };
+    int worstValue{ INT32_MAX };
+    for (Entry& e : bucket.entries)
+    {
+        const uint64_t data{ e.data.load(std::memory_order_relaxed) };
+        if (!data || (e.keyXorData.load(std::memory_order_relaxed) ^ data) == key)
+        {
+            // Same position: keep a deeper result from this search unless the
+            // new one is exact, and never forget the move.
+            if (data && bound != BOUND_EXACT && ageOf(data) == generation && depthOf(data) > depth + 2)
+                return;
+            if (!mv && data)
+                mv = unpack(data).move;
+            replace = &e;
+            break;
+        }
+        // Otherwise evict the shallowest entry, counting old searches' entries
+        // as eight plies shallower per search of age.
+        const int age{ (generation - ageOf(data)) & AGE_MASK };
+        const int value{ depthOf(data) - 8 * age };
+        if (value < worstValue)
+        {
+            worstValue = value;
+            replace = &e;
+        }
+    }
+    const uint64_t data{ pack(mv, score, eval, depth, bound, generation) };
+    replace->keyXorData.store(key ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::prefetch(uint64_t key) const
+{
+#if defined(_MSC_VER)
+    _mm_prefetch(reinterpret_cast<const char*>(&bucketFor(key)), _MM_HINT_T0);
+#else
+    __builtin_prefetch(&bucketFor(key));
+#endif
+}
+
+int TranspositionTable::hashfull() const
+{
+    int used{ 0 };
+    const size_t sampled{ bucketCount < 250 ? bucketCount : 250 };
+    for (size_t i = 0; i < sampled; i++)
+    {
+        for (const Entry& e : table[i].entries)
+        {
+            const uint64_t data{ e.data.load(std::memory_order_relaxed) };
+            if (data && ageOf(data) == generation)
+                used++;
+        }
+    }
+    return static_cast<int>(used * 1000 / (sampled * BUCKET_SIZE));
+}
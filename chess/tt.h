@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include "move.h"
+
+// === tt.h ===
+// Transposition table shared by all search threads.
+// The table is an array of cache-line-sized buckets of four entries. Each
+// entry is two 64-bit words: the packed data and the key XORed with that
+// data. A reader recomputes key ^ data and only accepts the entry if it
+// matches its own key, so an entry torn by two threads writing at once is
+// simply rejected instead of being read as garbage. No locks are taken.
+
+enum Bound : uint8_t {
+    BOUND_NONE, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT
+};
+
+constexpr int DEFAULT_HASH_MB{ 16 };
+constexpr int MAX_HASH_MB{ 65536 };
+
+struct TTData {
+    Move move{ 0 };
+    int score{ 0 };
+    int eval{ 0 };
+    int depth{ 0 };
+    Bound bound{ BOUND_NONE };
+};
+
+class TranspositionTable {
+public:
+    TranspositionTable() { resize(DEFAULT_HASH_MB); }
+    // Reallocates the table to the largest power-of-two size in megabytes
+    // that fits. Clears its contents.
+    void resize(size_t megabytes);
+    void clear();
+    // Called once per search so that stale entries can be told apart.
+    void newSearch() { generation = (generation + 1) & AGE_MASK; }
+    bool probe(uint64_t key, TTData& out) const;
+    void store(uint64_t key, Move mv, int score, int eval, int depth, Bound bound);
+    // Starts loading the bucket of a key into cache ahead of the probe.
+    void prefetch(uint64_t key) const;
+    // Permille of sampled entries written during the current search.
+    int hashfull() const;
+
+private:
+    static constexpr int BUCKET_SIZE{ 4 };
+    static constexpr uint8_t AGE_MASK{ 0x3F };
+
+    struct Entry {
+        std::atomic<uint64_t> keyXorData{ 0 };
+        std::atomic<uint64_t> data{ 0 };
+    };
+    struct alignas(64) Bucket {
+        Entry entries[BUCKET_SIZE];
+    };
+
+    // Data layout, from least significant bit:
+    // move (16) | score (16) | eval (16) | depth (8) | bound (2) | age (6)
+    static uint64_t pack(Move mv, int score, int eval, int depth, Bound bound, uint8_t age);
+    static TTData unpack(uint64_t data);
+    static uint8_t ageOf(uint64_t data) { return static_cast<uint8_t>(data >> 58); }
+    static int depthOf(uint64_t data) { return static_cast<int8_t>((data >> 48) & 0xFF); }
+
+    Bucket& bucketFor(uint64_t key) const { return table[key & (bucketCount - 1)]; }
+
+    std::unique_ptr<Bucket[]> table;
+    size_t bucketCount{ 0 };
+    uint8_t generation{ 0 };
+};
+
+extern TranspositionTable TT;
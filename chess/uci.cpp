@@ -1,62 +1,119 @@
 #include "uci.h"
+#include <algorithm>
+#include <charconv>
 #include <iostream>
 #include <sstream>
 
-struct nextMoveEval
-{
-    Move move;
-    int eval;
+// Selective search switches and parameters, exposed as UCI options so their
+// effect can be measured (see SearchParams).
+struct SwitchOption {
+    const char* name;
+    bool SearchParams::* value;
+};
+static constexpr SwitchOption SWITCH_OPTIONS[]{
+    { "NullMove", &SearchParams::nullMove },
+    { "LMR", &SearchParams::lmr },
+    { "ReverseFutility", &SearchParams::reverseFutility },
+    { "Futility", &SearchParams::futility },
+    { "Razoring", &SearchParams::razoring },
+    { "CheckExtensions", &SearchParams::checkExtensions },
+};
+
+struct SpinOption {
+    const char* name;
+    int SearchParams::* value;
+    int min;
+    int max;
+};
+static constexpr SpinOption SPIN_OPTIONS[]{
+    { "NullMoveMinDepth", &SearchParams::nullMoveMinDepth, 1, 20 },
+    { "NullMoveBase", &SearchParams::nullMoveBase, 0, 10 },
+    { "NullMoveDivisor", &SearchParams::nullMoveDivisor, 1, 20 },
+    { "NullMoveVerifyDepth", &SearchParams::nullMoveVerifyDepth, 1, MAX_PLY },
+    { "LMRBase", &SearchParams::lmrBase, 0, 300 },
+    { "LMRDivisor", &SearchParams::lmrDivisor, 50, 1000 },
+    { "RFPMaxDepth", &SearchParams::rfpMaxDepth, 0, 20 },
+    { "RFPMargin", &SearchParams::rfpMargin, 0, 1000 },
+    { "FutilityMaxDepth", &SearchParams::futilityMaxDepth, 0, 20 },
+    { "FutilityBase", &SearchParams::futilityBase, 0, 1000 },
+    { "FutilityMargin", &SearchParams::futilityMargin, 0, 1000 },
+    { "RazorMaxDepth", &SearchParams::razorMaxDepth, 0, 20 },
+    { "RazorMargin", &SearchParams::razorMargin, 0, 2000 },
 };
 
-void go_eval(int depth, Position& pos, int& current_eval)
+// Parses a whole token as a number. GUI and command-line input can't be
+// trusted, so a bad token leaves value unchanged and returns false instead
+// of throwing.
+template <typename T>
+static bool parseNumber(const std::string& token, T& value)
 {
-    if (depth == 0)
-    {
-        int eval = materialEval(pos);
-        switch (!pos.sideToMove)    //,     
-        {
-        case BLACK:
-            if (eval < current_eval)
-                current_eval = eval;
-            break;
-        case WHITE:
-            if (eval > current_eval)
-                current_eval = eval;
-            break;
-        default:
-            break;
-        }
-        return;
-    }
-    Movelist mvlist = generateLegalMoves(pos);
-    int sz = mvlist.size();
-    int currentMove{-CHECKMATE_EVALUATION + 2 * CHECKMATE_EVALUATION * (pos.sideToMove == BLACK)};
-    for (int i = 0; i < sz; ++i) {
-        pos.makeMove(mvlist[i]);
-        go_eval(depth - 1, pos, currentMove);
-        pos.unmakeMove(mvlist[i]);
-    }
-    switch (!pos.sideToMove)    //,     
-    {
-    case BLACK:
-        if (currentMove < current_eval)
-            current_eval = currentMove;
-        break;
-    case WHITE:
-        if (currentMove > current_eval)
-            current_eval = currentMove;
-        break;
-    default:
-        break;
-    }
-    return;
+    T parsed{};
+    const char* end{ token.data() + token.size() };
+    const auto [ptr, ec] = std::from_chars(token.data(), end, parsed);
+    if (ec != std::errc() || ptr != end)
+        return false;
+    value = parsed;
+    return true;
+}
+
+// "cp <x>", or "mate <n>" in moves (negative when getting mated).
+static std::string formatScore(int score)
+{
+    if (score >= MATE_BOUND)
+        return "mate " + std::to_string((CHECKMATE_EVALUATION - score + 1) / 2);
+    if (score <= -MATE_BOUND)
+        return "mate " + std::to_string(-(CHECKMATE_EVALUATION + score) / 2);
+    return "cp " + std::to_string(score);
+}
+
+void UCIInterface::installReporters() {
+    search.setReporters(
+        [this](const SearchResult& r) {
+            std::string pv;
+            for (Move mv : r.pv)
+                pv += " " + toStringUCI(mv);
+            const int64_t nps{ static_cast<int64_t>(r.nodes * 1000 / std::max<int64_t>(r.time, 1)) };
+            sendInfo("depth " + std::to_string(r.depth) + " seldepth " + std::to_string(r.selDepth)
+                + " score " + formatScore(r.score) + " nodes " + std::to_string(r.nodes)
+                + " nps " + std::to_string(nps) + " hashfull " + std::to_string(TT.hashfull())
+                + " time " + std::to_string(r.time) + " pv" + pv);
+        },
+        [this](int depth, Move mv, int moveNumber) {
+            sendInfo("depth " + std::to_string(depth) + " currmove " + toStringUCI(mv)
+                + " currmovenumber " + std::to_string(moveNumber));
+        });
 }
 
 void UCIInterface::startUCI() {
+    // Searches run on their own thread, so this loop keeps reading commands
+    // (stop, ponderhit, isready, quit) while one is in progress.
     std::string input;
     while (std::getline(std::cin, input)) {
-        parseCommand(input);
+        // A malformed command must not take the engine down with it.
+        try {
+            parseCommand(input);
+        }
+        catch (const std::exception& e) {
+            send(std::string("info string error: ") + e.what());
+        }
     }
+    stopSearch();
+}
+
+void UCIInterface::waitForSearch() {
+    if (searchThread.joinable())
+        searchThread.join();
+}
+
+void UCIInterface::stopSearch() {
+    search.stop();
+    waitForSearch();
+}
+
+void UCIInterface::send(const std::string& line) {
+    // Both the input thread and the search thread write to stdout.
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::cout << line << std::endl;
 }
 
 void UCIInterface::parseCommand(const std::string& command) {
@@ -71,25 +128,57 @@ void UCIInterface::parseCommand(const std::string& command) {
     if (tokens.empty()) return;
 
     if (tokens[0] == "uci") {
-        std::cout << "id name Blins\n";
-        std::cout << "id author Mikhail D.\n";
-        std::cout << "uciok\n";
+        send("id name Blins");
+        send("id author Mikhail D.");
+        send("option name Hash type spin default " + std::to_string(DEFAULT_HASH_MB) + " min 1 max " + std::to_string(MAX_HASH_MB));
+        send("option name Clear Hash type button");
+        send("option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS));
+        send("option name EvalFile type string default <empty>");
+        const SearchParams defaults{};
+        for (const SwitchOption& o : SWITCH_OPTIONS)
+            send(std::string("option name ") + o.name + " type check default " + (defaults.*o.value ? "true" : "false"));
+        for (const SpinOption& o : SPIN_OPTIONS)
+            send(std::string("option name ") + o.name + " type spin default " + std::to_string(defaults.*o.value)
+                + " min " + std::to_string(o.min) + " max " + std::to_string(o.max));
+        send("uciok");
     }
     else if (tokens[0] == "isready") {
-        std::cout << "readyok\n";
+        send("readyok");
+    }
+    else if (tokens[0] == "stop") {
+        stopSearch();
+    }
+    else if (tokens[0] == "ponderhit") {
+        search.ponderhit();
+    }
+    else if (tokens[0] == "quit") {
+        stopSearch();
+        exit(0);
     }
+    // The remaining commands change what the search works on, so they stop
+    // a running search first. Just waiting for it would hang on "go infinite"
+    // or "go ponder", which only end on "stop".
     else if (tokens[0] == "ucinewgame") {
-        initializeLookupTables();
+        stopSearch();
+        TT.clear();
+        search.clear();
+    }
+    else if (tokens[0] == "bench") {
+        stopSearch();
+        runBench(tokens);
+    }
+    else if (tokens[0] == "setoption") {
+        stopSearch();
+        handleSetOption(tokens);
     }
     else if (tokens[0] == "position") {
+        stopSearch();
         handlePosition(tokens);
     }
     else if (tokens[0] == "go") {
+        stopSearch();
         handleGo(tokens);
     }
-    else if (tokens[0] == "quit") {
-        exit(0);
-    }
 }
 
 void UCIInterface::handlePosition(const std::vector<std::string>& tokens) {
@@ -106,10 +195,10 @@ void UCIInterface::handlePosition(const std::vector<std::string>& tokens) {
     }
     else if (tokens.size() > 1 && tokens[1] == "fen")
     {
-        if (tokens.size() < 7)
+        if (tokens.size() < 8)
             return;
         pos.setFromFen(tokens[2] + " " + tokens[3] + " " + tokens[4] + " " + tokens[5] + " " + tokens[6] + " " + tokens[7]);
-        if (tokens.size() > 7 && tokens[8] == "moves")
+        if (tokens.size() > 8 && tokens[8] == "moves")
         {
             for (int i = 9; i < tokens.size(); i++)
             {
@@ -120,45 +209,156 @@ void UCIInterface::handlePosition(const std::vector<std::string>& tokens) {
 
 }
 
+void UCIInterface::handleSetOption(const std::vector<std::string>& tokens) {
+    // setoption name <id> [value <x>]; option names may contain spaces.
+    std::string name;
+    std::string value;
+    size_t i = 1;
+    if (i < tokens.size() && tokens[i] == "name")
+        i++;
+    for (; i < tokens.size() && tokens[i] != "value"; i++)
+        name += (name.empty() ? "" : " ") + tokens[i];
+    for (i++; i < tokens.size(); i++)
+        value += (value.empty() ? "" : " ") + tokens[i];
+
+    if (name == "Hash" && !value.empty())
+    {
+        int mb{ 0 };
+        if (parseNumber(value, mb) && mb >= 1 && mb <= MAX_HASH_MB)
+            {
+            TT.resize(mb);
+            hashMb = mb;
+        }
+    }
+    else if (name == "Clear Hash")
+    {
+        TT.clear();
+    }
+    else if (name == "Threads" && !value.empty())
+    {
+        int threads{ 0 };
+        if (parseNumber(value, threads) && threads >= 1 && threads <= MAX_THREADS)
+            search.setThreads(threads);
+    }
+    else if (name == "EvalFile" && !value.empty() && value != "<empty>")
+    {
+        try {
+            NNUE.load(value);
+            send("info string loaded network " + value + " (" + NNUE.kernelName() + ")");
+        }
+        catch (const std::exception& e) {
+            send(std::string("info string ") + e.what());
+        }
+    }
+    else if (!value.empty())
+    {
+        setSearchParam(name, value);
+    }
+}
+
+void UCIInterface::setSearchParam(const std::string& name, const std::string& value) {
+    SearchParams params{ search.params() };
+    bool found{ false };
+    for (const SwitchOption& o : SWITCH_OPTIONS) {
+        if (name == o.name) {
+            params.*o.value = (value == "true");
+            found = true;
+        }
+    }
+    for (const SpinOption& o : SPIN_OPTIONS) {
+        if (name == o.name) {
+            int v{ 0 };
+            if (!parseNumber(value, v) || v < o.min || v > o.max)
+                return;
+            params.*o.value = v;
+            found = true;
+        }
+    }
+    if (found)
+        search.setParams(params);
+}
+
+void UCIInterface::runBench(const std::vector<std::string>& tokens) {
+    // bench [depth] [threads] [hash]
+    // Missing or malformed values fall back to the defaults.
+    int depth{ DEFAULT_BENCH_DEPTH };
+    int threads{ DEFAULT_BENCH_THREADS };
+    int mb{ DEFAULT_BENCH_HASH_MB };
+    if (tokens.size() > 1)
+        parseNumber(tokens[1], depth);
+    if (tokens.size() > 2)
+        parseNumber(tokens[2], threads);
+    if (tokens.size() > 3)
+        parseNumber(tokens[3], mb);
+    const size_t savedThreads{ search.threadCount() };
+    // The per-iteration info lines would drown the bench's own output.
+    search.setReporters(nullptr, nullptr);
+    search.setThreads(threads);
+    TT.resize(std::clamp(mb, 1, MAX_HASH_MB));
+    {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        bench(search, std::clamp(depth, 1, MAX_PLY - 1), std::cout);
+    }
+    // Leave the engine as the GUI configured it.
+    search.setThreads(savedThreads);
+    TT.resize(hashMb);
+    search.clear();
+    installReporters();
+}
+
 void UCIInterface::handleGo(const std::vector<std::string>& tokens) {
     if (tokens.size() > 1 && tokens[1] == "perft")
     {
-        int i = 1;
-        if (tokens.size() > 2 && (i = std::stoi(tokens[2])))
-            if (i>0)
-                perft_parallel(i, pos);
+        int depth = 1;
+        if (tokens.size() > 2)
+            parseNumber(tokens[2], depth);
+        if (depth > 0)
+        {
+            perftTable.clear();
+            perftDivide(depth, pos, perftTable, threadPool, std::cout);
+        }
     }
     else
     {
-        Movelist mvlist = generateLegalMoves(pos);
-        int sz = mvlist.size();
-        nextMoveEval BestMove{ Move(),-2*CHECKMATE_EVALUATION + 4*CHECKMATE_EVALUATION * (pos.sideToMove == BLACK) };
-        for (int i = 0; i < sz; ++i) {
-            nextMoveEval currentMove{ mvlist[i],-CHECKMATE_EVALUATION + 2* CHECKMATE_EVALUATION * (pos.sideToMove == BLACK) };
-            std::cout << toStringUCI(mvlist[i]);
-            pos.makeMove(mvlist[i]);
-            go_eval(4, pos, currentMove.eval);
-            pos.unmakeMove(mvlist[i]);
-            switch (pos.sideToMove)    //,     
-            {
-            case BLACK:
-                if (currentMove.eval < BestMove.eval)
-                    BestMove = currentMove;
-                break;
-            case WHITE:
-                if (currentMove.eval > BestMove.eval)
-                    BestMove = currentMove;
-                break;
-            default:
+        SearchLimits limits{};
+        for (size_t i = 1; i < tokens.size(); i++)
+        {
+            const std::string& key = tokens[i];
+            if (key == "infinite")
+                limits.infinite = true;
+            else if (key == "ponder")
+                limits.ponder = true;
+            else if (i + 1 >= tokens.size())
                 break;
-            }
+            else if (key == "wtime")
+                parseNumber(tokens[++i], limits.time[WHITE]);
+            else if (key == "btime")
+                parseNumber(tokens[++i], limits.time[BLACK]);
+            else if (key == "winc")
+                parseNumber(tokens[++i], limits.inc[WHITE]);
+            else if (key == "binc")
+                parseNumber(tokens[++i], limits.inc[BLACK]);
+            else if (key == "movestogo")
+                parseNumber(tokens[++i], limits.movesToGo);
+            else if (key == "movetime")
+                parseNumber(tokens[++i], limits.moveTime);
+            else if (key == "depth")
+                parseNumber(tokens[++i], limits.depth);
+            else if (key == "nodes")
+                parseNumber(tokens[++i], limits.nodes);
         }
-        sendBestMove(toStringUCI(BestMove.move));
-        //std::cout << pos.pretty_cb();
-        //std::cout << pretty(pos.occupancy);
-        //std::cout << pretty(pos.bbByColour[WHITE]);
-        //std::cout << pretty(pos.bbByColour[BLACK]);
-        //std::cout << pretty(pos.bbByType[PAWN]);
+        // A bare "go" keeps the old fixed-depth behaviour.
+        if (tokens.size() == 1)
+            limits.depth = DEFAULT_SEARCH_DEPTH;
+        // The search gets its own copy, so "position" can't change the board
+        // under it.
+        searchPos = pos;
+        search.prepare(limits, searchPos.sideToMove);
+        searchThread = std::thread([this] {
+            SearchResult result = search.think(searchPos);
+            // "0000" is the UCI null move, sent when there is no legal move.
+            sendBestMove(result.bestMove ? toStringUCI(result.bestMove) : "0000", toStringUCI(result.ponderMove));
+            });
     }
 }
 //
@@ -167,22 +367,26 @@ void UCIInterface::handleGo(const std::vector<std::string>& tokens) {
 //}
 
 void UCIInterface::sendBestMove(const std::string& bestMove, const std::string& ponderMove) {
-    std::cout << "bestmove " << bestMove;
-    if (!ponderMove.empty()) {
-        std::cout << " ponder " << ponderMove;
-    }
-    std::cout << "\n";
+    if (!ponderMove.empty())
+        send("bestmove " + bestMove + " ponder " + ponderMove);
+    else
+        send("bestmove " + bestMove);
 }
 
 void UCIInterface::sendInfo(const std::string& info) {
-    std::cout << "info " << info << "\n";
+    send("info " + info);
 }
 
 
 
-int main()
+int main(int argc, char* argv[])
 {
     UCIInterface uci;
+    // "chess bench [depth] [threads] [hash]" runs the bench and exits.
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        uci.runBench(std::vector<std::string>(argv + 1, argv + argc));
+        return 0;
+    }
     uci.startUCI();
   /*  uint64_t num1 = 0xab235f76fa0027c1;
     uint64_t res1 = murmur64(num1);
@@ -191,7 +395,7 @@ int main()
         uint64_t buf = 1ULL << i;
         uint64_t num2 = num1 ^ buf;
         uint64_t res2 = murmur64(num2);
-        int fin = countOnes(res1 ^ res2);
+        int fin = popCount(res1 ^ res2);
         std::cout << "i = " << i << "\t" << fin << std::endl;
     }*/
     
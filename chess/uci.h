@@ -1,21 +1,49 @@
 #pragma once
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #include "position.h"
 #include "evaluation.h"
 #include "movegen.h"
 #include "move.h"
+#include "search.h"
+#include "perft.h"
+#include "bench.h"
+
+const int DEFAULT_SEARCH_DEPTH = 6;
 
 class UCIInterface {
 public:
+    UCIInterface() {
+        pos.setStartingPosition();
+        installReporters();
+    }
     void startUCI();
+    // Runs "bench [depth] [threads] [hash]"; tokens[0] is "bench".
+    void runBench(const std::vector<std::string>& tokens);
     //void sendMove(const std::string& move);
     void sendBestMove(const std::string& bestMove, const std::string& ponderMove = "");
     void sendInfo(const std::string& info);
 
 private:
     Position pos;
+    Position searchPos;     // the copy being searched on searchThread
+    Search search;
+    std::thread searchThread;
+    std::mutex outputMutex;
+    PerftTable perftTable;
+    ThreadPool threadPool;
+    int hashMb{ DEFAULT_HASH_MB };   // the Hash option, restored after a bench
     void parseCommand(const std::string& command);
+    void send(const std::string& line);
+    // Routes the search's progress reports to "info" lines.
+    void installReporters();
+    void waitForSearch();
+    void stopSearch();
     void handlePosition(const std::vector<std::string>& tokens);
+    void handleSetOption(const std::vector<std::string>& tokens);
+    // Sets a selective search option; unknown names are ignored.
+    void setSearchParam(const std::string& name, const std::string& value);
     void handleGo(const std::vector<std::string>& tokens);
 };
\ No newline at end of file